@@ -1,19 +1,23 @@
 #pragma once
 
 #include "DynamicObject.h"
+#include "ObjectPool.h"
 
 namespace agp
 {
 	class Box;
 }
 
-class agp::Box : public DynamicObject
+// Box class
+// - pooled: spawned on mouse click
+class agp::Box : public DynamicObject, public Pooled<Box>
 {
 	private:
 
 	public:
 
 		Box(GameScene* scene, const RotatedRectF& obb);
+		virtual ~Box() { setSprite(nullptr, true); }
 
 		virtual std::string name() override { return strprintf("Box[%d]", _id); }
 };
\ No newline at end of file
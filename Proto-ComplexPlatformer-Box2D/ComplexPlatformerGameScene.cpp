@@ -34,6 +34,9 @@ ComplexPlatformerGameScene::ComplexPlatformerGameScene(const RectF& rect, const
 
 	// setup view
 	_view->setRect(RectF(0, 0, 24, 13, true));
+
+	// many fast moving rigid bodies: AABB tree with fat boxes
+	setUseAABBTree(true);
 }
 
 ComplexPlatformerGameScene::~ComplexPlatformerGameScene()
@@ -130,10 +133,7 @@ void ComplexPlatformerGameScene::updateWorld(float timeToSimulate)
 		// @TODO
 
 		// logic and animations
-		auto allObjects = objects();
-		for (auto& obj : allObjects)
-			if (!obj->freezed())
-				obj->update(timeToSimulate);
+		updateObjects(timeToSimulate);
 	}
 }
 
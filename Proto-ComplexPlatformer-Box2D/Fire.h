@@ -1,19 +1,23 @@
 #pragma once
 
 #include "DynamicObject.h"
+#include "ObjectPool.h"
 
 namespace agp
 {
 	class Fire;
 }
 
-class agp::Fire : public DynamicObject
+// Fire class
+// - pooled: spawned at every player shot
+class agp::Fire : public DynamicObject, public Pooled<Fire>
 {
 	private:
 
 	public:
 
 		Fire(GameScene* scene, const PointF& spawnPoint, const Vec2Df& velocity, int layer=0);
+		virtual ~Fire() { setSprite(nullptr, true); }
 
 		virtual void update(float dt) override;
 		virtual std::string name() override { return strprintf("Fire[%d]", _id); }
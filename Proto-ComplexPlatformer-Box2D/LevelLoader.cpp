@@ -18,6 +18,7 @@
 #include "mathUtils.h"
 #include "Gear.h"
 #include "Box.h"
+#include "Fire.h"
 #include "Slime.h"
 #include <iostream>
 
@@ -66,6 +67,8 @@ Scene* LevelLoader::load(const std::string& name)
 
 		// player
 		world->setPlayer(new Player(world, { 3, 10 }));
+		Fire::reservePool(64);
+		Box::reservePool(64);
 		
 		// decorative backgrounds and foregrounds
 		world->addBackgroundScene(new OverlayScene(world, spriteLoader->get("bg_sky")));
@@ -14,13 +14,14 @@
 #include "timeUtils.h"
 #include "collisionUtils.h"
 #include "sdlUtils.h"
-#include "GameScene.h"
+#include "RPGGameScene.h"
 
 using namespace agp;
 
 CollidableObject::CollidableObject(Scene* scene, const RotatedRectF& rrect, Sprite* sprite, int layer) :
 	MovableObject(scene, rrect, sprite, layer)
 {
+	addClassId<CollidableObject>();
 	_angle = rad2deg(rrect.angle);
 
 	defaultCollider();
@@ -28,6 +29,12 @@ CollidableObject::CollidableObject(Scene* scene, const RotatedRectF& rrect, Spri
 	// default collision: non compenetration
 	_compenetrable = false;
 	_collidable = true;
+	_detecting = false;
+
+	// objects never change scene: no cast at each update
+	_rpgScene = dynamic_cast<RPGGameScene*>(scene);
+
+	setCategory(category() | COLLIDABLE_CATEGORY);
 }
 
 
@@ -61,6 +68,13 @@ void CollidableObject::update(float dt)
 {
 	MovableObject::update(dt);
 
+	// pairwise collisions: detection/resolution deferred to the end of the step
+	if (_rpgScene && _rpgScene->pairwiseCollisions())
+	{
+		_rpgScene->addCollisionDetector(this);
+		return;
+	}
+
 	detectCollisions();
 	resolveCollisions();
 }
@@ -75,30 +89,57 @@ void CollidableObject::detectCollisions()
 	if (!_collidable)
 		return;
 
-	_collisionsPrev = _collisions;
-	_collisions.clear();
-	_collisionAxes.clear();
-	_collisionDepths.clear();
+	beginCollisions();
 
-	auto objectsInRect = _scene->objects(sceneCollider().boundingRect());
-	for (auto& obj : objectsInRect)
+	// collect candidates first, since collision handlers may kill/move objects
+	_collisionCandidates.clear();
+	_scene->objects(sceneCollider().boundingRect(), [this](Object* obj)
+		{
+			CollidableObject* collObj = obj->to<CollidableObject*>();
+			if (collObj && collObj != this)
+				_collisionCandidates.push_back(collObj);
+			return true;
+		}, COLLIDABLE_CATEGORY);
+	for (auto& collObj : _collisionCandidates)
 	{
-		CollidableObject* collObj = obj->to<CollidableObject*>();
-		if (collObj && collObj != this && collObj->collidable() && collidableWith(collObj))
+		if (collObj->collidable() && collidableWith(collObj))
 		{
 			Vec2Df axis;
 			float depth;
 			if (checkCollisionSAT(sceneCollider().verticesVec(), collObj->sceneCollider().verticesVec(), axis, depth))
 			{
-				_collisions.push_back(collObj);
-				_collisionAxes.push_back(axis);
-				_collisionDepths.push_back(depth);
+				addCollision(collObj, axis, depth);
 				collision(collObj, true, axis);
 				collObj->collision(this, true, -axis);
 			}
 		}
 	}
 
+	endCollisions();
+}
+
+void CollidableObject::beginCollisions()
+{
+	_collisionsPrev.clear();
+	for (auto collObj : _collisions)
+		_collisionsPrev.push_back(collObj->handle());
+	_collisions.clear();
+	_collisionAxes.clear();
+	_collisionDepths.clear();
+	_detecting = true;
+}
+
+void CollidableObject::addCollision(CollidableObject* with, const Vec2Df& axis, float depth)
+{
+	_collisions.push_back(with);
+	_collisionAxes.push_back(axis);
+	_collisionDepths.push_back(depth);
+}
+
+void CollidableObject::endCollisions()
+{
+	_detecting = false;
+
 	// first remove objects marked 'to be killed' from collision list
 	// since they will not be accessible in the next iteration
 	size_t j = 0;
@@ -116,13 +157,16 @@ void CollidableObject::detectCollisions()
 	_collisionAxes.resize(j);
 	_collisionDepths.resize(j);
 
-	// decollisions = previous collisions that are no more
-	for(auto collObj : _collisionsPrev)
-		if (std::find(_collisions.begin(), _collisions.end(), collObj) == _collisions.end())
+	// decollisions = previous collisions that are no more (and still allocated)
+	for (auto& handle : _collisionsPrev)
+	{
+		CollidableObject* collObj = static_cast<CollidableObject*>(_scene->object(handle));
+		if (collObj && std::find(_collisions.begin(), _collisions.end(), collObj) == _collisions.end())
 		{
 			collision(collObj, false, Vec2Df());
 			collObj->collision(this, false, Vec2Df());
 		}
+	}
 }
 
 bool CollidableObject::collision(CollidableObject* with, bool begin, const Vec2Df& normal)
@@ -14,14 +14,28 @@
 namespace agp
 {
 	class CollidableObject;
+	class RPGGameScene;
+	template <> struct ClassId<CollidableObject> { static constexpr int bit = 16; };
+
+	// object categories used to prune scene queries (see Object::category)
+	enum Categories : unsigned int
+	{
+		COLLIDABLE_CATEGORY = 1 << 1,	// CollidableObject (bit 0 is DEFAULT_CATEGORY)
+		STATIC_CATEGORY = 1 << 2,		// StaticObject
+		DYNAMIC_CATEGORY = 1 << 3		// DynamicObject
+	};
 }
 
 // CollidableObject class.
 // - defines a collider (default: object rect)
 // - implements collision detection and resolution
 // - defines logic collision (see collision method)
+// - in RPGGameScene (pairwise collisions on), detection is done by the scene once per
+//   step over the broadphase pairs, then each object resolves its own collisions
 class agp::CollidableObject : public MovableObject
 {
+	friend class RPGGameScene;
+
 	protected:
 
 		// collisions
@@ -32,10 +46,16 @@ class agp::CollidableObject : public MovableObject
 		std::vector<CollidableObject*> _collisions;
 		std::vector<Vec2Df> _collisionAxes;
 		std::vector<float> _collisionDepths;
-		std::vector<CollidableObject*> _collisionsPrev;
+		std::vector<ObjectHandle> _collisionsPrev;				// kept across steps (handles)
+		std::vector<CollidableObject*> _collisionCandidates;	// reused across steps (no allocation per query)
+		bool _detecting;						// between beginCollisions and endCollisions
+		RPGGameScene* _rpgScene;				// scene as RPGGameScene (nullptr otherwise), cast once
 
 		// collision detection/resolution
 		virtual void detectCollisions();
+		void beginCollisions();
+		void addCollision(CollidableObject* with, const Vec2Df& axis, float depth);
+		void endCollisions();
 		virtual void resolveCollisions() = 0;  // see Dynamic and Static objects
 
 		// set collider to default (whole rect)
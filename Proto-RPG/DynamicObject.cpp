@@ -15,6 +15,7 @@ using namespace agp;
 DynamicObject::DynamicObject(Scene* scene, const RotatedRectF& rrect, Sprite* sprite, int layer) :
 	CollidableObject(scene, rrect, sprite, layer)
 {
+	addClassId<DynamicObject>();
 	// dynamic objects are compenetrable vs. each other by default
 	// (e.g. player vs. spanwable, collectibles vs. enemies, ...)
 	// compenetration does not need to be resolved in these cases
@@ -22,6 +23,8 @@ DynamicObject::DynamicObject(Scene* scene, const RotatedRectF& rrect, Sprite* sp
 	_compenetrable = true;
 
 	_facingDir = Direction::DOWN;
+
+	setCategory(category() | DYNAMIC_CATEGORY);
 }
 
 void DynamicObject::move(Direction xDir, Direction yDir)
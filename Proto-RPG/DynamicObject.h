@@ -13,6 +13,7 @@
 namespace agp
 {
 	class DynamicObject;
+	template <> struct ClassId<DynamicObject> { static constexpr int bit = 17; };
 }
 
 // DynamicObject class.
@@ -9,6 +9,8 @@ using namespace agp;
 Enemy::Enemy(Scene* scene, const RotatedRectF& rrect, Sprite* sprite, int layer)
 	: DynamicObject(scene, rrect, sprite, layer)
 {
+	addClassId<Enemy>();
+	_activationPolicy = COARSE_TICK;
 }
 
 bool Enemy::collision(CollidableObject* with, bool begin, const Vec2Df& normal)
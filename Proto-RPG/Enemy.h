@@ -14,10 +14,12 @@
 namespace agp
 {
 	class Enemy;
+	template <> struct ClassId<Enemy> { static constexpr int bit = 19; };
 }
 
 // Enemy
 // - base class for all enemies
+// - coarse-ticked out of the activation region (see GameScene): keeps patrolling at a reduced rate
 class agp::Enemy : public DynamicObject
 {
 	protected:
@@ -21,6 +21,7 @@ using namespace agp;
 Link::Link(Scene* scene, const PointF& pos)
 	: DynamicObject(scene, RectF( pos.x, pos.y, 1, 1.5f ), nullptr, 2)
 {
+	addClassId<Link>();
 	_fit = false;
 
 	_collider.size.x -= 0.2f;
@@ -104,11 +105,9 @@ void Link::hurt()
 
 void Link::interact()
 {
-	auto objects = _scene->raycast({ rect().center(), rect().center() + 1 * dir2vec(_facingDir) });
-	for (auto& obj : objects)
-		if (obj->to<NPC*>())
-		{
-			obj->to<NPC*>()->interact();
-			break;
-		}
+	float tNear;
+	Object* npc = _scene->raycastNearest({ rect().center(), rect().center() + 1 * dir2vec(_facingDir) }, tNear,
+		[](Object* obj) { return obj->to<NPC*>() != nullptr; });
+	if (npc)
+		npc->to<NPC*>()->interact();
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 namespace agp
 {
 	class Link;
+	template <> struct ClassId<Link> { static constexpr int bit = 20; };
 	class Sword;
 }
 
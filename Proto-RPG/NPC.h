@@ -16,6 +16,7 @@
 namespace agp
 {
 	class NPC;
+	template <> struct ClassId<NPC> { static constexpr int bit = 21; };
 	class Sword;
 }
 
@@ -68,8 +68,10 @@ void Pathfinding::update()
 				_cells[i][j].synced = true;
 			}
 
-		auto allObjects = _actor->scene()->objects();
-		for (auto obj : allObjects)
+		// only static objects that may overlap the actor within the search area
+		RectF queryRect(actorSearchArea.pos - actorRect.size / 2, actorSearchArea.br() + actorRect.size / 2);
+		auto staticObjects = _actor->scene()->objects(queryRect, STATIC_CATEGORY);
+		for (auto obj : staticObjects)
 		{
 			if (obj->to<StaticObject*>())
 			{
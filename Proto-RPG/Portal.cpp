@@ -23,9 +23,15 @@ Portal::Portal(Scene* scene, const RotatedRectF& rrect, Portal* dest) :
 void Portal::setDestination(Portal* dest)
 { 	
 	if(dest)
-		_task = [this, dest]()
+		_task = [this, destHandle = dest->handle()]()
 		{
-			_watched->setPos(dest->rect().center() - _watched->rect().size/2);
+			// handles: both portals may have been deallocated meanwhile (e.g. level change)
+			Object* watched = _scene->object(_watched);
+			Portal* dest = static_cast<Portal*>(_scene->object(destHandle));
+			if (!watched || !dest)
+				return;
+
+			watched->setPos(dest->rect().center() - watched->rect().size/2);
 			dest->_playerArrived = true;
 			dynamic_cast<RPGGameScene*>(_scene)->setTransitionEnter(false);
 			dynamic_cast<RPGGameScene*>(_scene)->setTransitionExit(true);
@@ -38,9 +44,9 @@ void Portal::setDestination(Portal* dest)
 
 bool Portal::collision(CollidableObject* with, bool begin, const Vec2Df& normal)
 {
-	if (with == _watched && _playerArrived && begin == false)
+	if (with->handle() == _watched && _playerArrived && begin == false)
 		_playerArrived = false;
-	else if (with == _watched && !_playerArrived && begin)
+	else if (with->handle() == _watched && !_playerArrived && begin)
 	{
 		dynamic_cast<GameScene*>(_scene)->player()->setFreezed(true);
 		dynamic_cast<RPGGameScene*>(_scene)->setTransitionEnter(true);
@@ -20,6 +20,7 @@
 #include "shaderUtils.h"
 #include "CPUShaderWindow.h"
 #include "StaticObject.h"
+#include "collisionUtils.h"
 
 using namespace agp;
 
@@ -29,6 +30,15 @@ RPGGameScene::RPGGameScene(const RectF& rect, const Point& pixelUnitSize, float
 	_transitionEnter = false;
 	_transitionExit = false;
 	_transitionCounter = 0;
+	_pairwiseCollisions = true;
+
+	// level geometry never moves: packed static index, built once at level load
+	setUseQuadtree(true);
+	setStaticCategories(STATIC_CATEGORY);
+
+	// offscreen enemies are coarse-ticked, at 1/4 rate at most (walls are thin)
+	setActivation(true, PointF(4, 4), PointF(4, 4));
+	setLodDistances(16, std::numeric_limits<float>::infinity());
 	
 	// SNES aspect ratio
 	_view->setRect(RectF(0, 0, 16, 14));
@@ -53,6 +63,101 @@ void RPGGameScene::updateControls(float timeToSimulate)
 	dynamic_cast<Link*>(_player)->move(xDir, yDir);
 }
 
+void RPGGameScene::updateWorld(float timeToSimulate)
+{
+	if (!_pairwiseCollisions)
+	{
+		GameScene::updateWorld(timeToSimulate);
+		return;
+	}
+
+	// semi-fixed timestep
+	_timeToSimulateAccum += timeToSimulate;
+	while (_timeToSimulateAccum >= _dt)
+	{
+		updateObjects(_dt);			// physics, logic, animation
+		detectResolveCollisions();
+		rebuildSpatialIndex();
+		_timeToSimulateAccum -= _dt;
+	}
+}
+
+void RPGGameScene::detectResolveCollisions()
+{
+	for (auto& obj : _collisionDetectors)
+		if (obj->collidable())
+			obj->beginCollisions();
+
+	// broadphase: pairs with at least one dynamic object
+	intersections(_collisionPairs, COLLIDABLE_CATEGORY, DYNAMIC_CATEGORY);
+
+	// colliders reaching out of their object rect (e.g. rotated): the missing pairs are
+	// found by collider bounds, as CollidableObject::detectCollisions does
+	for (auto& obj : _collisionDetectors)
+	{
+		if (!obj->_detecting)
+			continue;
+
+		RectF bounds = obj->sceneCollider().boundingRect();
+		if (obj->rect().contains(bounds))
+			continue;
+
+		objects(bounds, [this, obj](Object* other)
+			{
+				// skip pairs already found, or found from the other object (lower id)
+				CollidableObject* collObj = other->to<CollidableObject*>();
+				if (!collObj || collObj == obj || other->rect().intersects(obj->rect()) ||
+					!((obj->category() | other->category()) & DYNAMIC_CATEGORY))
+					return true;
+				if (collObj->_detecting && collObj->id() < obj->id() && obj->rect().intersects(collObj->sceneCollider().boundingRect()))
+					return true;
+				_collisionPairs.emplace_back(obj, other);
+				return true;
+			}, COLLIDABLE_CATEGORY);
+	}
+
+	// narrowphase: one test per pair, collision reported to the detecting object(s)
+	// (same callbacks as CollidableObject::detectCollisions, collision handlers may kill/move objects)
+	for (auto& pair : _collisionPairs)
+	{
+		CollidableObject* a = pair.first->to<CollidableObject*>();
+		CollidableObject* b = pair.second->to<CollidableObject*>();
+		if (!a || !b)
+			continue;
+
+		bool aDetects = a->_detecting && b->collidable() && a->collidableWith(b);
+		bool bDetects = b->_detecting && a->collidable() && b->collidableWith(a);
+		if (!aDetects && !bDetects)
+			continue;
+
+		Vec2Df axis;
+		float depth;
+		if (!checkCollisionSAT(a->sceneCollider().verticesVec(), b->sceneCollider().verticesVec(), axis, depth))
+			continue;
+
+		if (aDetects)
+		{
+			a->addCollision(b, axis, depth);
+			a->collision(b, true, axis);
+			b->collision(a, true, -axis);
+		}
+		if (bDetects)
+		{
+			b->addCollision(a, -axis, depth);
+			b->collision(a, true, -axis);
+			a->collision(b, true, axis);
+		}
+	}
+
+	for (auto& obj : _collisionDetectors)
+	{
+		if (obj->_detecting)
+			obj->endCollisions();
+		obj->resolveCollisions();
+	}
+	_collisionDetectors.clear();
+}
+
 void RPGGameScene::event(SDL_Event& evt)
 {
 	GameScene::event(evt);
@@ -133,10 +238,14 @@ void RPGGameScene::update(float timeToSimulate)
 
 bool RPGGameScene::isEmpty(const RectF& rect)
 {
-	Objects candidates = _quadtree.queryObjects(rect);
-	for (auto obj : candidates)
-		if (dynamic_cast<StaticObject*>(obj) && obj->intersectsRect(rect))
-			return false;
+	// only static objects are obstacles
+	bool empty = true;
+	objects(rect, [&](Object* obj)
+		{
+			if (obj->intersectsRect(rect))
+				empty = false;
+			return empty;
+		}, STATIC_CATEGORY);
 
-	return true;
+	return empty;
 }
\ No newline at end of file
@@ -13,12 +13,15 @@
 namespace agp
 {
 	class RPGGameScene;
+	class CollidableObject;
 	class Link;
 	class LevelLoader;
 }
 
 // RPGGameScene class
 // - customizes parent's class Game to adapt to RPG games
+// - pairwise collisions (default): collisions are detected once per step over the
+//   broadphase pairs (see Scene::intersections), each pair tested once for both objects
 class agp::RPGGameScene : public GameScene
 {
 	protected:
@@ -28,8 +31,17 @@ class agp::RPGGameScene : public GameScene
 		bool _transitionExit;
 		float _transitionCounter;
 
+		// collisions
+		bool _pairwiseCollisions;
+		ObjectPairs _collisionPairs;							// reused across steps
+		std::vector<CollidableObject*> _collisionDetectors;		// objects updated in the current step
+
 		// helper functions overrides
 		virtual void updateControls(float timeToSimulate) override;
+		virtual void updateWorld(float timeToSimulate) override;
+
+		// collision detection/resolution of the current step
+		virtual void detectResolveCollisions();
 
 	public:
 
@@ -39,6 +51,11 @@ class agp::RPGGameScene : public GameScene
 		// getters/setters
 		virtual void setTransitionEnter(bool active);
 		virtual void setTransitionExit(bool active);
+		bool pairwiseCollisions() const { return _pairwiseCollisions; }
+		virtual void setPairwiseCollisions(bool on) { _pairwiseCollisions = on; }
+
+		// called by collidable objects when updated (pairwise collisions only)
+		void addCollisionDetector(CollidableObject* obj) { _collisionDetectors.push_back(obj); }
 
 		// override (+custom game controls)
 		virtual void event(SDL_Event& evt) override;
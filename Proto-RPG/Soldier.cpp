@@ -57,6 +57,10 @@ void Soldier::changeState(State newState)
 
 void Soldier::AI(bool targetReached)
 {
+	// interned once: AI runs every step
+	static const TimerId GOSLEEP = TimerWheel::intern("gosleep");
+	static const TimerId WAKE = TimerWheel::intern("wake");
+
 	Link* link = dynamic_cast<GameScene*>(_scene)->player()->to<Link*>();
 	float distanceFromLink = distance(link);
 	float distanceToTrigger = 100;
@@ -66,8 +70,12 @@ void Soldier::AI(bool targetReached)
 		changeState(State::PATROL);
 
 	// while patrolling, schedule random transition to sleep mode if link is far away
+	// (pending transitions are kept)
 	else if (_state == State::PATROL && distanceFromLink >= distanceToTrigger)
-		schedule("gosleep", float(1 + rand() % 10), [this]() { changeState(State::SLEEP); }, 0, false);
+	{
+		if (!scheduled(GOSLEEP))
+			schedule(GOSLEEP, float(1 + rand() % 10), [this]() { changeState(State::SLEEP); });
+	}
 
 	// while patrolling, switch to chase mode if Link is close
 	else if (_state == State::PATROL && distanceFromLink < distanceToTrigger)
@@ -78,10 +86,13 @@ void Soldier::AI(bool targetReached)
 	else if (_state == State::SLEEP)
 	{
 		if (distanceFromLink > 5)
-			schedule("wake", float(1 + rand() % 5), [this]() { changeState(State::PATROL); }, 0, false);
+		{
+			if (!scheduled(WAKE))
+				schedule(WAKE, float(1 + rand() % 5), [this]() { changeState(State::PATROL); });
+		}
 		else
 		{
-			unschedule("wake");
+			unschedule(WAKE);
 			changeState(State::CHASING);
 		}
 	}
@@ -14,8 +14,9 @@ using namespace agp;
 
 StaticObject::StaticObject(Scene* scene, const RotatedRectF& rrect, Sprite* sprite, int layer) :
 	CollidableObject(scene, rrect, sprite, layer)
-{	
-
+{
+	addClassId<StaticObject>();
+	setCategory(category() | STATIC_CATEGORY);
 }
 
 bool StaticObject::collision(CollidableObject* with, bool begin, const Vec2Df& normal)
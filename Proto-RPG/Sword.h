@@ -10,16 +10,19 @@
 #pragma once
 #include "DynamicObject.h"
 #include "Enemy.h"
+#include "ObjectPool.h"
 
 namespace agp
 {
 	class Sword;
+	template <> struct ClassId<Sword> { static constexpr int bit = 22; };
 	class Link;
 }
 
 // Link's sword class.
 // - starts brandishing when spawned
-class agp::Sword : public DynamicObject
+// - pooled: spawned at every attack
+class agp::Sword : public DynamicObject, public Pooled<Sword>
 {
 	protected:
 
@@ -28,7 +31,7 @@ class agp::Sword : public DynamicObject
 	public:
 
 		Sword(Link* link);
-		virtual ~Sword() {}
+		virtual ~Sword() { setSprite(nullptr, true); }
 
 		// extends game logic (+adapt to Link)
 		virtual void update(float dt) override;
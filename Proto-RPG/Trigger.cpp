@@ -15,14 +15,14 @@ Trigger::Trigger(Scene* scene, const RotatedRectF& rrect, CollidableObject* watc
 	CollidableObject(scene, rrect, nullptr)
 {
 	_task = task;
-	_watched = watched;
+	_watched = watched ? watched->handle() : ObjectHandle();
 	_compenetrable = true;
 }
 
 // extends logic collision (+trigger behavior)
 bool Trigger::collision(CollidableObject* with, bool begin, const Vec2Df& normal)
 {
-	if (with == _watched && begin)
+	if (with->handle() == _watched && begin)
 	{
 		_task();
 		return true;
@@ -23,12 +23,15 @@ using namespace agp;
 CollidableObject::CollidableObject(Scene* scene, const RectF& rect, Sprite* sprite, int layer) :
 	MovableObject(scene, rect, sprite, layer)
 {
+	addClassId<CollidableObject>();
 	defaultCollider();
 
 	// default collision: non compenetration
 	_compenetrable = false;
 	_collidable = true;
 
+	setCategory(category() | COLLIDABLE_CATEGORY);
+
 	// default collision system: Continous Collision Detection (CCD)
 	_CCD = true;
 
@@ -123,13 +126,23 @@ void CollidableObject::detectDecollisions()
 	_collisionAxes.resize(j);
 	_collisionDepths.resize(j);
 
-	// decollisions = previous collisions that are no more
-	for (auto collObj : _collisionsPrev)
-		if (std::find(_collisions.begin(), _collisions.end(), collObj) == _collisions.end())
+	// decollisions = previous collisions that are no more (and still allocated)
+	for (auto& handle : _collisionsPrev)
+	{
+		CollidableObject* collObj = static_cast<CollidableObject*>(_scene->object(handle));
+		if (collObj && std::find(_collisions.begin(), _collisions.end(), collObj) == _collisions.end())
 		{
 			collision(collObj, false, Direction::NONE);
 			collObj->collision(this, false, Direction::NONE);
 		}
+	}
+}
+
+void CollidableObject::storeCollisionsPrev()
+{
+	_collisionsPrev.clear();
+	for (auto collObj : _collisions)
+		_collisionsPrev.push_back(collObj->handle());
 }
 
 void CollidableObject::detectResolveCollisionsCCD(float dt)
@@ -142,21 +155,21 @@ void CollidableObject::detectResolveCollisionsCCD(float dt)
 	PointF curPos = pos();
 	RectF curRect = sceneCollider();
 	setPos(pos() + _vel * dt);
-	std::vector<CollidableObject*> likely_collisions;
-	Objects items_in_rect = _scene->objects(sceneCollider().united(curRect));
-	for (auto item : items_in_rect)
-	{
-		CollidableObject* obj = item->to<CollidableObject*>();
-		if (obj && obj != this && obj->collidable() && collidableWith(obj))
-			likely_collisions.push_back(obj);
-	}
+	_collisionCandidates.clear();
+	_scene->objects(sceneCollider().united(curRect), [this](Object* item)
+		{
+			CollidableObject* obj = item->to<CollidableObject*>();
+			if (obj && obj != this && obj->collidable() && collidableWith(obj))
+				_collisionCandidates.push_back(obj);
+			return true;
+		}, COLLIDABLE_CATEGORY);
 	setPos(curPos);	// restore current pos
 
 	// sort collisions in ascending order of contact time
 	Vec2Df cp, cn;
 	float ct = 0, min_t = INFINITY;
 	std::vector<std::pair<CollidableObject*, float>> sortedByContactTime;
-	for (auto& obj : likely_collisions)
+	for (auto& obj : _collisionCandidates)
 		if (DynamicRectVsRect(sceneCollider(), vel() * dt, obj->sceneCollider(), cp, cn, ct))
 			sortedByContactTime.push_back({ obj, ct });
 	std::sort(sortedByContactTime.begin(), sortedByContactTime.end(),
@@ -168,7 +181,7 @@ void CollidableObject::detectResolveCollisionsCCD(float dt)
 
 	// solve the collisions in correct order
 	// also update collision metadata
-	_collisionsPrev = _collisions;
+	storeCollisionsPrev();
 	_collisions.clear();
 	_collisionAxes.clear();
 	_collisionDepths.clear();
@@ -183,7 +196,7 @@ void CollidableObject::detectResolveCollisionsCCD(float dt)
 				_collisionDepths.push_back(0);
 			}
 			else
-				_collisionsCompenetrables.insert(obj.first);
+				_collisionsCompenetrables.insert(obj.first->handle());
 
 			obj.first->collision(this, true, normal2dir(cn));
 			collision(obj.first, true, inverse(normal2dir(cn)));
@@ -192,14 +205,14 @@ void CollidableObject::detectResolveCollisionsCCD(float dt)
 	// detect de-collisions with compenetrables
 	for (auto it = _collisionsCompenetrables.begin(); it != _collisionsCompenetrables.end(); )
 	{
-		// remove objects marked 'to be killed' from collision list
-		// since they will not be accessible in the next iteration
-		if ((*it)->_killed)
+		// remove objects marked 'to be killed' (or already deallocated) from collision list
+		CollidableObject* obj = static_cast<CollidableObject*>(_scene->object(*it));
+		if (!obj || obj->_killed)
 			it = _collisionsCompenetrables.erase(it);
-		else if (sceneCollider().isSeparatedFrom((*it)->sceneCollider(), 0.1f))
+		else if (sceneCollider().isSeparatedFrom(obj->sceneCollider(), 0.1f))
 		{
-			collision(*it, false, Direction::NONE);
-			(*it)->collision(this, false, Direction::NONE);
+			collision(obj, false, Direction::NONE);
+			obj->collision(this, false, Direction::NONE);
 
 			it = _collisionsCompenetrables.erase(it);
 		}
@@ -216,16 +229,23 @@ void CollidableObject::detectCollisionsAABB()
 	if (!_collidable)
 		return;
 
-	_collisionsPrev = _collisions;
+	storeCollisionsPrev();
 	_collisions.clear();
 	_collisionAxes.clear();
 	_collisionDepths.clear();
 
-	auto objectsInRect = _scene->objects(sceneCollider());
-	for (auto& obj : objectsInRect)
+	// collect candidates first, since collision handlers may kill/move objects
+	_collisionCandidates.clear();
+	_scene->objects(sceneCollider(), [this](Object* obj)
+		{
+			CollidableObject* collObj = obj->to<CollidableObject*>();
+			if (collObj && collObj != this)
+				_collisionCandidates.push_back(collObj);
+			return true;
+		}, COLLIDABLE_CATEGORY);
+	for (auto& collObj : _collisionCandidates)
 	{
-		CollidableObject* collObj = obj->to<CollidableObject*>();
-		if (collObj && collObj != this && collObj->collidable() && collidableWith(collObj))
+		if (collObj->collidable() && collidableWith(collObj))
 		{
 			Direction axis;
 			float depth;
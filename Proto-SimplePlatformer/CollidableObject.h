@@ -14,6 +14,14 @@
 namespace agp
 {
 	class CollidableObject;
+	template <> struct ClassId<CollidableObject> { static constexpr int bit = 16; };
+
+	// object categories used to prune scene queries (see Object::category)
+	enum Categories : unsigned int
+	{
+		COLLIDABLE_CATEGORY = 1 << 1,	// CollidableObject (bit 0 is DEFAULT_CATEGORY)
+		STATIC_CATEGORY = 1 << 2		// StaticObject
+	};
 }
 
 // CollidableObject class.
@@ -30,11 +38,12 @@ class agp::CollidableObject : public MovableObject
 		bool _compenetrable;
 		const Color _colliderColor = { 255, 255, 0, 255 };
 		bool _CCD;
-		std::set<CollidableObject*> _collisionsCompenetrables;
+		std::set<ObjectHandle> _collisionsCompenetrables;		// kept across steps (handles)
 		std::vector<CollidableObject*> _collisions;
 		std::vector<Vec2Df> _collisionAxes;
 		std::vector<float> _collisionDepths;
-		std::vector<CollidableObject*> _collisionsPrev;
+		std::vector<ObjectHandle> _collisionsPrev;				// kept across steps (handles)
+		std::vector<CollidableObject*> _collisionCandidates;	// reused across steps (no allocation per query)
 		bool _fallingPrev;
 
 		// CCD collision detection/resolution
@@ -46,6 +55,7 @@ class agp::CollidableObject : public MovableObject
 
 		// decollissions
 		virtual void detectDecollisions();
+		void storeCollisionsPrev();
 
 		// set collider to default (whole rect)
 		void defaultCollider();
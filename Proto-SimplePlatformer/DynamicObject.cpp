@@ -14,6 +14,7 @@ using namespace agp;
 DynamicObject::DynamicObject(Scene* scene, const RectF& rect, Sprite* sprite, int layer) :
 	CollidableObject(scene, rect, sprite, layer)
 {
+	addClassId<DynamicObject>();
 	// dynamic objects are compenetrable vs. each other by default
 	// (e.g. player vs. spanwable, collectibles vs. enemies, ...)
 	// compenetration does not need to be resolved in these cases
@@ -8,14 +8,16 @@ using namespace agp;
 Enemy::Enemy(Scene* scene, const RectF& rect, Sprite* sprite, int layer)
 	: DynamicObject(scene, rect, sprite, layer)
 {
+	addClassId<Enemy>();
 	_smashable = true;
 	_dying = false;
 	_facingDir = Direction::LEFT;
+	_activationPolicy = FREEZE;
 }
 
 bool Enemy::collision(CollidableObject* with, bool begin, Direction fromDir)
 {
-	Mario* mario = dynamic_cast<Mario*>(with);
+	Mario* mario = with->to<Mario*>();
 
 	if (mario)
 	{
@@ -33,6 +35,7 @@ bool Enemy::collision(CollidableObject* with, bool begin, Direction fromDir)
 void Enemy::smash()
 {
 	_dying = true;
+	_activationPolicy = ALWAYS_ACTIVE;	// falls off screen, still has to die
 	_yGravityForce = 25;
 	_vel.y = -8;
 	_collidable = false;
@@ -14,10 +14,12 @@
 namespace agp
 {
 	class Enemy;
+	template <> struct ClassId<Enemy> { static constexpr int bit = 20; };
 }
 
 // Enemy
 // - base class for all enemies
+// - frozen out of the activation region (see GameScene) by default, until dying
 class agp::Enemy : public DynamicObject
 {
 	protected:
@@ -1,6 +1,7 @@
 #include "Hammer.h"
 #include "SpriteFactory.h"
 #include "Mario.h"
+#include "Scene.h"
 
 using namespace agp;
 
@@ -9,7 +10,8 @@ Hammer::Hammer(Scene* scene, const PointF& pos, Enemy* thrower)
 {
 	_collider.adjust(0.2f, 0.2f, -0.2f, -0.2f);
 	_smashable = true;
-	_thrower = thrower;
+	_activationPolicy = COARSE_TICK;
+	_thrower = thrower->handle();
 	_throwing = false;
 	_yGravityForce = 0;
 	_xFrictionForce = 0;
@@ -23,7 +25,8 @@ Hammer::Hammer(Scene* scene, const PointF& pos, Enemy* thrower)
 			_throwing = true;
 			_yGravityForce = 25;
 			velAdd(Vec2Df(0, -9));
-			_xDir = _thrower->facingDir();
+			Enemy* thrower = static_cast<Enemy*>(_scene->object(_thrower));
+			_xDir = thrower ? thrower->facingDir() : Direction::LEFT;
 			_angularVelocity = 1000;
 		});
 }
@@ -33,10 +36,17 @@ void Hammer::update(float dt)
 	Enemy::update(dt);
 
 	if (!_throwing)
-		setPos(_thrower->rect().pos + PointF(2 / 16.0f, 0));
+	{
+		// dropped if the thrower has been deallocated
+		Enemy* thrower = static_cast<Enemy*>(_scene->object(_thrower));
+		if (thrower)
+			setPos(thrower->rect().pos + PointF(2 / 16.0f, 0));
+		else if (!_killed)
+			kill();
+	}
 }
 
 bool Hammer::collidableWith(CollidableObject* obj)
 {
-	return dynamic_cast<Mario*>(obj);
+	return obj->is<Mario>();
 }
\ No newline at end of file
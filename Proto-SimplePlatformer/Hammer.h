@@ -10,22 +10,27 @@
 #pragma once
 
 #include "Enemy.h"
+#include "ObjectPool.h"
 
 namespace agp
 {
 	class Hammer;
 }
 
-class agp::Hammer : public Enemy
+// Hammer class
+// - pooled: thrown every ~0.7 s by each HammerBrother
+// - coarse-ticked off screen like its thrower (not frozen: flies away until killed)
+class agp::Hammer : public Enemy, public Pooled<Hammer>
 {
 	protected:
 
-		Enemy* _thrower;
+		ObjectHandle _thrower;	// handle: the thrower may die while holding the hammer
 		bool _throwing;
 
 	public:
 
 		Hammer(Scene* scene, const PointF& pos, Enemy* thrower);
+		virtual ~Hammer() { setSprite(nullptr, true); }
 
 		// extends game logic (+Hammer logic)
 		virtual void update(float dt) override;
@@ -12,6 +12,9 @@ HammerBrother::HammerBrother(Scene* scene, const PointF& pos)
 {
 	_collider.adjust(0.1f, 0.4f, -0.1f, -1 / 16.0f);
 
+	// keeps jumping and throwing off screen, at a reduced rate (CCD copes with the larger dt)
+	_activationPolicy = COARSE_TICK;
+
 	_sprites["walk"] = SpriteFactory::instance()->get("hammer_brother_walk");
 	_sprites["throw"] = SpriteFactory::instance()->get("hammer_brother_throw");
 	_sprites["jump"] = SpriteFactory::instance()->get("hammer_brother_jump");
@@ -15,6 +15,7 @@ using namespace agp;
 KinematicObject::KinematicObject(Scene* scene, const RectF& rect, Sprite* sprite, int layer) :
 	CollidableObject(scene, rect, sprite, layer)
 {
+	addClassId<KinematicObject>();
 	_compenetrable = false;
 }
 
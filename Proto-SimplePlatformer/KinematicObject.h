@@ -15,6 +15,7 @@ namespace agp
 {
 	class DynamicObject;
 	class KinematicObject;
+	template <> struct ClassId<KinematicObject> { static constexpr int bit = 19; };
 }
 
 // KinematicObject class.
@@ -20,6 +20,7 @@ using namespace agp;
 Mario::Mario(Scene* scene, const PointF& pos)
 	: DynamicObject(scene, RectF( pos.x + 1 / 16.0f, pos.y, 1, 1 ), nullptr)
 {
+	addClassId<Mario>();
 	_metalslugdemo = false;
 
 	if (_metalslugdemo)
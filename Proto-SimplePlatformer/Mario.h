@@ -16,6 +16,7 @@
 namespace agp
 {
 	class Mario;
+	template <> struct ClassId<Mario> { static constexpr int bit = 21; };
 	class Sword;
 }
 
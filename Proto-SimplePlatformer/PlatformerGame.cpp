@@ -37,7 +37,7 @@ void PlatformerGame::freeze(bool on)
 	PlatformerGameScene* gameScene = dynamic_cast<PlatformerGameScene*>(_scenes[0]);
 	if (gameScene)
 	{
-		Objects objects = gameScene->objects();
+		const Objects& objects = gameScene->objects();
 		for (auto& obj : objects)
 			if (obj != reinterpret_cast<Object*>(gameScene->player()))
 				obj->setFreezed(on);
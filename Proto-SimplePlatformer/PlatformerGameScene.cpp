@@ -15,6 +15,7 @@
 #include "timeUtils.h"
 #include "HUD.h"
 #include "PlatformerGame.h"
+#include "CollidableObject.h"
 
 using namespace agp;
 
@@ -24,7 +25,17 @@ PlatformerGameScene::PlatformerGameScene(const RectF& rect, const Point& pixelUn
 	// NES aspect ratio (16 x 15)
 	_view->setRect(RectF(0, -12, 16, 15));
 
-	_useQuadtree = true;
+	// tile-aligned world: uniform grid with cell size derived from pixelUnitSize
+	setUseUniformGrid(true);
+
+	// CollidableObject moves each object several times per step
+	setDeferSpatialUpdates(true);
+
+	// bricks, boxes, pipes and terrain never move: packed static index, built once at level load
+	setStaticCategories(STATIC_CATEGORY);
+
+	// enemies wake up just before entering the screen
+	setActivation(true, PointF(4, 4), PointF(4, 4));
 }
 
 void PlatformerGameScene::updateControls(float timeToSimulate)
@@ -14,6 +14,7 @@ using namespace agp;
 
 StaticObject::StaticObject(Scene* scene, const RectF& rect, Sprite* sprite, int layer) :
 	CollidableObject(scene, rect, sprite, layer)
-{	
-
+{
+	addClassId<StaticObject>();
+	setCategory(category() | STATIC_CATEGORY);
 }
\ No newline at end of file
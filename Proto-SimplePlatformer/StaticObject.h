@@ -13,6 +13,7 @@
 namespace agp
 {
 	class StaticObject;
+	template <> struct ClassId<StaticObject> { static constexpr int bit = 18; };
 }
 
 // StaticObject class.
@@ -65,12 +65,12 @@ void Sword::update(float dt)
 
 bool Sword::collidableWith(CollidableObject* obj)
 {
-	return dynamic_cast<Enemy*>(obj);
+	return obj->is<Enemy>();
 }
 
 bool Sword::collision(CollidableObject* with, bool begin, Direction fromDir)
 {
-	Enemy* enemy = dynamic_cast<Enemy*>(with);
+	Enemy* enemy = with->to<Enemy*>();
 	if (enemy)
 		enemy->smash();
 
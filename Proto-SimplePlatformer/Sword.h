@@ -9,6 +9,7 @@
 
 #pragma once
 #include "DynamicObject.h"
+#include "ObjectPool.h"
 
 namespace agp
 {
@@ -17,7 +18,8 @@ namespace agp
 }
 
 // Link's sword class.
-class agp::Sword : public DynamicObject
+// - pooled: spawned at every attack
+class agp::Sword : public DynamicObject, public Pooled<Sword>
 {
 	protected:
 
@@ -26,7 +28,7 @@ class agp::Sword : public DynamicObject
 	public:
 
 		Sword(Mario* link);
-		virtual ~Sword() {}
+		virtual ~Sword() { setSprite(nullptr, true); }
 
 		// extends game logic (+adapt to Link)
 		virtual void update(float dt) override;
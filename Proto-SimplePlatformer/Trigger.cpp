@@ -15,14 +15,14 @@ Trigger::Trigger(Scene* scene, const RectF& rect, CollidableObject* watched, std
 	CollidableObject(scene, rect, nullptr)
 {
 	_task = task;
-	_watched = watched;
+	_watched = watched ? watched->handle() : ObjectHandle();
 	_compenetrable = true;
 }
 
 // extends logic collision (+trigger behavior)
 bool Trigger::collision(CollidableObject* with, bool begin, Direction fromDir)
 {
-	if (with == _watched)
+	if (with->handle() == _watched)
 	{
 		_task();
 		return true;
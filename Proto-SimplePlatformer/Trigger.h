@@ -23,7 +23,7 @@ class agp::Trigger : public CollidableObject
 	private:
 
 		std::function<void()> _task;
-		CollidableObject* _watched;
+		ObjectHandle _watched;		// handle: the watched object may be deallocated first
 
 	public:
 
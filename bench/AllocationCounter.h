@@ -0,0 +1,27 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+namespace agp
+{
+    class AllocationCounter;
+}
+
+// Allocation counter class
+// - counts heap allocations of the whole program: global operator new (all
+//   variants) is replaced in AllocationCounter.cpp, which must be linked in
+// - take count() before and after a code section to get its allocations
+class agp::AllocationCounter
+{
+    public:
+
+        // heap allocations since program start (all threads)
+        static unsigned long long count();
+};
@@ -0,0 +1,218 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "CrowdBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include "GameScene.h"
+#include "Object.h"
+#include "ObjectPool.h"
+#include "AllocationCounter.h"
+
+using namespace agp;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // objects found by the queries of the current step (all scenes run one at a time)
+    long long found = 0;
+
+    void queryAround(Scene* scene, Object* obj)
+    {
+        scene->objects(obj->rect(), [](Object*) { found++; return true; });
+    }
+
+    // game scene stepped one fixed step at a time (no player, fixed camera)
+    class CrowdScene : public GameScene
+    {
+        public:
+
+            CrowdScene(const RectF& rect, float dt) : GameScene(rect, Point(16, 16), dt)
+            {
+                _cameraFollowsPlayer = false;
+            }
+    };
+
+    // short-lived ballistic projectile (like hammers)
+    class Projectile : public Object, public Pooled<Projectile>
+    {
+        private:
+
+            PointF _vel;
+            float _lifetime;
+
+        public:
+
+            Projectile(Scene* scene, const PointF& pos, const PointF& vel, float lifetime, unsigned int category) :
+                Object(scene, RectF(pos.x, pos.y, 0.5f, 0.5f)), _vel(vel), _lifetime(lifetime)
+            {
+                setCategory(category);
+            }
+
+            virtual void update(float dt) override
+            {
+                Object::update(dt);
+
+                _vel.y += 20 * dt;
+                setPos(rect().pos + _vel * dt);
+                queryAround(_scene, this);
+
+                _lifetime -= dt;
+                if (_lifetime <= 0)
+                    _scene->killObject(this);
+            }
+    };
+
+    // walker pacing back and forth, throwing projectiles (like hammer brothers)
+    class Walker : public Object
+    {
+        private:
+
+            float _pivotX;
+            const CrowdBenchmark::Config& _config;
+            float _vx;
+            float _throwTimer;
+            unsigned int _projectileCategory;
+
+        public:
+
+            Walker(Scene* scene, float x, float throwPhase, const CrowdBenchmark::Config& config, unsigned int category, unsigned int projectileCategory) :
+                Object(scene, RectF(x, -1.5f, 1, 1.5f)), _pivotX(x), _config(config), _vx(config.walkerSpeed), _throwTimer(throwPhase), _projectileCategory(projectileCategory)
+            {
+                setCategory(category);
+            }
+
+            virtual void update(float dt) override
+            {
+                Object::update(dt);
+
+                float x = rect().pos.x;
+                if (x >= _pivotX + _config.walkerRange)
+                    _vx = -_config.walkerSpeed;
+                else if (x <= _pivotX - _config.walkerRange)
+                    _vx = _config.walkerSpeed;
+                setPos(PointF(x + _vx * dt, rect().pos.y));
+                queryAround(_scene, this);
+
+                _throwTimer -= dt;
+                if (_throwTimer <= 0)
+                {
+                    _throwTimer += _config.throwPeriod;
+                    new Projectile(_scene, rect().pos, PointF(_vx > 0 ? 3.0f : -3.0f, -8), _config.projectileLifetime, _projectileCategory);
+                }
+            }
+    };
+}
+
+CrowdBenchmark::CrowdBenchmark() :
+    CrowdBenchmark(Config())
+{
+}
+
+CrowdBenchmark::CrowdBenchmark(const Config& config) :
+    _config(config)
+{
+    if (_config.walkers <= 0 || _config.steps <= 0)
+        throw "CrowdBenchmark::CrowdBenchmark: walkers and steps must be > 0";
+}
+
+CrowdBenchmark::Result CrowdBenchmark::run(const std::string& name, GameScene* scene)
+{
+    Result result;
+    result.name = name;
+
+    // terrain tiles, then walkers (level load: bulk loaded at the first step)
+    std::mt19937 rng(_config.seed);
+    scene->setStaticCategories(TERRAIN_CATEGORY);
+    for (int x = int(_config.world.pos.x); x < int(_config.world.pos.x + _config.world.size.x); x++)
+        (new Object(scene, RectF(float(x), 0, 1, 1)))->setCategory(TERRAIN_CATEGORY);
+    for (int i = 0; i < _config.walkers; i++)
+    {
+        float x = 20.0f + rng() % 100;
+        float throwPhase = std::uniform_real_distribution<float>(0, _config.throwPeriod)(rng);
+        new Walker(scene, x, throwPhase, _config, WALKER_CATEGORY, PROJECTILE_CATEGORY);
+    }
+    Projectile::reservePool(2 * _config.walkers);
+
+    for (int i = 0; i < _config.warmUpSteps; i++)
+        scene->update(_config.dt);
+
+    bool reference = _reference.empty();
+    double stepNs = 0, foundCount = 0;
+    unsigned long long allocations0 = AllocationCounter::count();
+    for (int i = 0; i < _config.steps; i++)
+    {
+        found = 0;
+        Clock::time_point t0 = Clock::now();
+        scene->update(_config.dt);
+        stepNs += double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+        foundCount += double(found);
+        result.maxObjects = std::max(result.maxObjects, int(scene->objects().size()));
+
+        if (reference)
+            _reference.push_back(found);
+        else if (_reference[i] != found)
+            result.mismatches++;
+    }
+    unsigned long long allocations = AllocationCounter::count() - allocations0;
+
+    result.stepNs = stepNs / _config.steps;
+    result.allocations = double(allocations) / _config.steps;
+    result.found = foundCount / _config.steps;
+    delete scene;
+
+    return result;
+}
+
+void CrowdBenchmark::printHeader()
+{
+    printf("%-30s %12s %12s %12s %12s %10s\n", "scene", "step", "allocs/step", "found/step", "objects", "errors");
+}
+
+void CrowdBenchmark::print(const Result& r)
+{
+    printf("%-30s %12.0f %12.1f %12.0f %12d %10lld\n", r.name.c_str(), r.stepNs, r.allocations, r.found, r.maxObjects, r.mismatches);
+}
+
+std::vector<CrowdBenchmark::Result> CrowdBenchmark::runAll()
+{
+    printf("Crowd benchmark: %d walkers throwing a projectile every %.1f s, %d steps (after %d warm up steps)\n",
+        _config.walkers, _config.throwPeriod, _config.steps, _config.warmUpSteps);
+
+    // the platformer configuration first (reference results)
+    CrowdScene* grid = new CrowdScene(_config.world, _config.dt);
+    grid->setUseUniformGrid(true);
+    grid->setDeferSpatialUpdates(true);
+    CrowdScene* quadtree = new CrowdScene(_config.world, _config.dt);
+    quadtree->setUseQuadtree(true);
+    CrowdScene* linear = new CrowdScene(_config.world, _config.dt);
+    linear->setUseLinearQuadtree(true);
+
+    std::vector<std::pair<std::string, GameScene*>> scenes =
+    {
+        { "UniformGrid (deferred)", grid },
+        { "Quadtree", quadtree },
+        { "LinearQuadtree", linear }
+    };
+
+    _reference.clear();
+    std::vector<Result> results;
+    printHeader();
+    for (auto& scene : scenes)
+    {
+        results.push_back(run(scene.first, scene.second));
+        print(results.back());
+    }
+    printf("(ns per step, heap allocations per step, objects found by the per-object queries)\n");
+
+    return results;
+}
@@ -0,0 +1,86 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "geometryUtils.h"
+
+namespace agp
+{
+    class GameScene;
+    class CrowdBenchmark;
+}
+
+// Crowd benchmark class
+// - the 1000-HammerBrother stress setup without game assets: walkers pacing back and
+//   forth on a strip of static terrain, each one throwing a short-lived pooled
+//   projectile every second (about one projectile in flight per walker)
+// - every object moves and queries the objects around it each step (like collision
+//   detection), the terrain is in the static index
+// - same scenario (same random seed) on one GameScene per dynamic index: the
+//   platformer configuration (UniformGrid, deferred updates), Quadtree, and
+//   LinearQuadtree (rebuilt once per step, for scenes where most objects move)
+// - time and heap allocations per step (see AllocationCounter), after a warm up:
+//   projectiles come from a pre-warmed pool, so steady steps should not allocate
+// - objects found by the queries must be the same on every backend (errors otherwise)
+// - needs a Game instance (GameScene creates a view): offscreen rendering is enough
+class agp::CrowdBenchmark
+{
+    public:
+
+        struct Config
+        {
+            int walkers = 1000;
+            RectF world = RectF(0, -16, 128, 32);   // terrain at y = 0, walkers in [20, 120)
+            float dt = 1 / 60.0f;
+            int warmUpSteps = 120;                  // not measured (pools, lists and indices grow)
+            int steps = 300;
+            float walkerSpeed = 1.5f;               // scene units per second
+            float walkerRange = 2;                  // half range of the horizontal movement
+            float throwPeriod = 1;                  // seconds between throws (random phase)
+            float projectileLifetime = 1;           // seconds
+            unsigned int seed = 1;
+        };
+
+        struct Result
+        {
+            std::string name;
+            double stepNs = 0;          // per step
+            double allocations = 0;     // heap allocations per step
+            double found = 0;           // objects found by the queries per step
+            int maxObjects = 0;         // live objects (terrain included)
+            long long mismatches = 0;   // steps with results different from the first backend
+        };
+
+    private:
+
+        // parameters
+        static constexpr unsigned int TERRAIN_CATEGORY = 1 << 0;
+        static constexpr unsigned int WALKER_CATEGORY = 1 << 1;
+        static constexpr unsigned int PROJECTILE_CATEGORY = 1 << 2;
+
+        // attributes
+        Config _config;
+        std::vector<long long> _reference;  // objects found per step by the first backend
+
+        // helper functions
+        Result run(const std::string& name, GameScene* scene);     // on an empty scene, deleted at the end
+        static void printHeader();
+        static void print(const Result& r);
+
+    public:
+
+        CrowdBenchmark();
+        CrowdBenchmark(const Config& config);
+
+        // runs the scenario on every configuration and prints a report
+        std::vector<Result> runAll();
+};
@@ -0,0 +1,453 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SpatialIndexBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "Scene.h"
+#include "GameScene.h"
+#include "Object.h"
+#include "Quadtree.h"
+#include "UniformGrid.h"
+#include "AABBTree.h"
+#include "LinearQuadtree.h"
+#include "StaticIndex.h"
+#include "AllocationCounter.h"
+
+using namespace agp;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double elapsedNs(const Clock::time_point& t0)
+    {
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+    }
+
+    // GameScene under test, seen as an index: it stores a mirror of each benchmark
+    // object (same rect and category), query results are mapped back to the originals
+    class GameSceneIndex : public SpatialIndex
+    {
+        private:
+
+            GameScene* _scene;
+            std::vector<Object*> _mirrors;      // indexed by original dense id (nullptr = not stored)
+            std::vector<Object*> _originals;    // indexed by mirror dense id
+
+            Object* original(Object* mirror) const { return _originals[mirror->denseId()]; }
+            ObjectFilter mirrorFilter(const ObjectFilter& filter) const
+            {
+                if (!filter)
+                    return nullptr;
+                return [this, &filter](Object* mirror) { return filter(original(mirror)); };
+            }
+
+        public:
+
+            GameSceneIndex(const RectF& rect, float dt, unsigned int staticCategories, bool deferSpatialUpdates)
+            {
+                _scene = new GameScene(rect, Point(16, 16), dt);
+                _scene->setUseQuadtree(true);
+                _scene->setStaticCategories(staticCategories);
+                _scene->setDeferSpatialUpdates(deferSpatialUpdates);
+            }
+            virtual ~GameSceneIndex() { delete _scene; }
+
+            virtual RectF rect() const override { return _scene->rect(); }
+
+            virtual void add(Object* obj) override
+            {
+                Object* mirror = new Object(_scene, obj->rect());
+                mirror->setCategory(obj->category());
+                if (obj->denseId() >= int(_mirrors.size()))
+                    _mirrors.resize(obj->denseId() + 1, nullptr);
+                if (mirror->denseId() >= int(_originals.size()))
+                    _originals.resize(mirror->denseId() + 1, nullptr);
+                _mirrors[obj->denseId()] = mirror;
+                _originals[mirror->denseId()] = obj;
+            }
+            virtual void remove(Object* obj) override
+            {
+                _scene->killObject(_mirrors[obj->denseId()]);
+                _mirrors[obj->denseId()] = nullptr;
+            }
+            virtual void update(Object* obj) override { _mirrors[obj->denseId()]->setRect(obj->rect()); }
+            virtual void clear() override
+            {
+                for (auto& mirror : _mirrors)
+                {
+                    if (mirror)
+                        _scene->killObject(mirror);
+                    mirror = nullptr;
+                }
+            }
+
+            // new mirrors join the scene objects (moves reach the indices by the scene itself,
+            // at once or at the next query if deferred)
+            virtual void rebuild() override { _scene->refreshObjects(); }
+
+            using SpatialIndex::queryObjects;
+            virtual void queryObjects(const RectF& rect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) const override
+            {
+                _scene->objects(rect, [this, &visitor](Object* mirror) { return visitor(original(mirror)); }, categoryMask);
+            }
+            virtual void raycast(const LineF& line, RaycastHits& hits) const override
+            {
+                _scene->raycast(line, hits);
+                for (auto& hit : hits)
+                    hit.first = original(hit.first);
+            }
+            virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) const override
+            {
+                Object* mirror = _scene->raycastNearest(line, tNear, mirrorFilter(filter));
+                return mirror ? original(mirror) : nullptr;
+            }
+            virtual std::vector<Object*> queryNearest(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) const override
+            {
+                std::vector<Object*> objects = _scene->nearestObjects(point, k, mirrorFilter(filter), maxDistance);
+                for (auto& obj : objects)
+                    obj = original(obj);
+                return objects;
+            }
+            virtual std::vector<Object*> queryRadius(const PointF& point, float radius, const ObjectFilter& filter = nullptr) const override
+            {
+                std::vector<Object*> objects = _scene->objectsWithin(point, radius, mirrorFilter(filter));
+                for (auto& obj : objects)
+                    obj = original(obj);
+                return objects;
+            }
+            virtual void queryIntersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const override
+            {
+                _scene->intersections(pairs, categoryMask, activeMask);
+                for (auto& pair : pairs)
+                    pair = std::make_pair(original(pair.first), original(pair.second));
+                SpatialIndex::sortPairs(pairs);
+            }
+    };
+}
+
+SpatialIndexBenchmark::SpatialIndexBenchmark() :
+    SpatialIndexBenchmark(Config())
+{
+}
+
+SpatialIndexBenchmark::SpatialIndexBenchmark(const Config& config) :
+    _config(config), _rng(config.seed)
+{
+    if (_config.objects <= 0 || _config.steps <= 0)
+        throw "SpatialIndexBenchmark::SpatialIndexBenchmark: objects and steps must be > 0";
+
+    // objects are created once, and restored to their initial rects before each run
+    _scene = new Scene(_config.world, Point(16, 16));
+    for (int i = 0; i < _config.objects; i++)
+    {
+        bool large = random(0, 1) < _config.largeFraction;
+        PointF size(
+            random(_config.minSize.x, large ? _config.largeSize.x : _config.maxSize.x),
+            random(_config.minSize.y, large ? _config.largeSize.y : _config.maxSize.y));
+        RectF rect = randomRect(size);
+        _objects.push_back(new Object(_scene, rect));
+        _initialRects.push_back(rect);
+
+        bool moving = random(0, 1) < _config.movingFraction;
+        _velocities.push_back(moving ? PointF(random(-_config.maxSpeed, _config.maxSpeed), random(-_config.maxSpeed, _config.maxSpeed)) : PointF(0, 0));
+        _objects.back()->setCategory(moving ? (random(0, 1) < 0.5f ? 1 << 1 : 1 << 2) : STATIC_CATEGORY);
+        if (_objects.back()->denseId() >= int(_removed.size()))
+            _removed.resize(_objects.back()->denseId() + 1, false);
+    }
+    _scene->refreshObjects();
+}
+
+SpatialIndexBenchmark::~SpatialIndexBenchmark()
+{
+    delete _scene;
+}
+
+RectF SpatialIndexBenchmark::randomRect(const PointF& size)
+{
+    PointF pos(
+        random(_config.world.pos.x, _config.world.pos.x + _config.world.size.x - size.x),
+        random(_config.world.pos.y, _config.world.pos.y + _config.world.size.y - size.y));
+    return RectF(pos.x, pos.y, size.x, size.y);
+}
+
+void SpatialIndexBenchmark::move(Object* obj, PointF& velocity)
+{
+    // bounce within the world
+    PointF pos = obj->rect().pos + velocity * _config.dt;
+    const RectF& world = _config.world;
+    if (pos.x < world.pos.x || pos.x + obj->rect().size.x > world.pos.x + world.size.x)
+    {
+        velocity.x = -velocity.x;
+        pos.x = std::min(std::max(pos.x, world.pos.x), world.pos.x + world.size.x - obj->rect().size.x);
+    }
+    if (pos.y < world.pos.y || pos.y + obj->rect().size.y > world.pos.y + world.size.y)
+    {
+        velocity.y = -velocity.y;
+        pos.y = std::min(std::max(pos.y, world.pos.y), world.pos.y + world.size.y - obj->rect().size.y);
+    }
+    obj->setPos(pos);
+}
+
+unsigned int SpatialIndexBenchmark::randomMask()
+{
+    // one or two categories, static or not
+    static const unsigned int masks[] = { 1 << 1, 1 << 2, STATIC_CATEGORY, (1 << 1) | STATIC_CATEGORY, (1 << 2) | STATIC_CATEGORY };
+    return masks[std::uniform_int_distribution<int>(0, 4)(_rng)];
+}
+
+void SpatialIndexBenchmark::mismatch(Result& result, const std::string& what)
+{
+    if (result.mismatches++ < MAX_REPORTED_MISMATCHES)
+        printf("SpatialIndexBenchmark[%s] -> mismatch: %s\n", result.name.c_str(), what.c_str());
+}
+
+SpatialIndexBenchmark::Result SpatialIndexBenchmark::run(const std::string& name, SpatialIndex* index)
+{
+    Result result;
+    result.name = name;
+
+    // same objects, moves and queries for all runs
+    _rng.seed(_config.seed);
+    for (std::size_t i = 0; i < _objects.size(); i++)
+        _objects[i]->setRect(_initialRects[i]);
+    std::vector<PointF> velocities = _velocities;
+    std::fill(_removed.begin(), _removed.end(), false);
+
+    // insert
+    Clock::time_point t0 = Clock::now();
+    for (auto obj : _objects)
+        index->add(obj);
+    index->rebuild();
+    result.insertNs = elapsedNs(t0) / _objects.size();
+
+    std::vector<Object*> found, expected;
+    RaycastHits hits, expectedHits;
+    ObjectPairs pairs, expectedPairs;
+    std::vector<Object*> removed;
+    long long moved = 0;
+    double updateNs = 0, rectQueryNs = 0, raycastNs = 0, nearestNs = 0, broadphaseNs = 0;
+    unsigned long long allocations = 0, allocations0 = 0;
+
+    // reference results exclude the objects removed from the index
+    ObjectFilter stored = [this](Object* obj) { return !_removed[obj->denseId()]; };
+    auto removedHit = [&stored](const std::pair<Object*, float>& hit) { return !stored(hit.first); };
+    auto removedPair = [&stored](const std::pair<Object*, Object*>& pair) { return !stored(pair.first) || !stored(pair.second); };
+
+    for (int step = 0; step < _config.steps; step++)
+    {
+        // removals (not timed): objects removed the previous step are re-added where they are now
+        for (auto obj : removed)
+        {
+            index->add(obj);
+            _removed[obj->denseId()] = false;
+        }
+        removed.clear();
+        for (int i = 0; i < int(_config.removedFraction * _objects.size()); i++)
+        {
+            Object* obj = _objects[std::uniform_int_distribution<int>(0, int(_objects.size()) - 1)(_rng)];
+            if (_removed[obj->denseId()])
+                continue;
+
+            index->remove(obj);
+            _removed[obj->denseId()] = true;
+            removed.push_back(obj);
+        }
+
+        // update (moves are not timed, index updates are)
+        for (std::size_t i = 0; i < _objects.size(); i++)
+        {
+            if (velocities[i].x == 0 && velocities[i].y == 0)
+                continue;
+
+            move(_objects[i], velocities[i]);
+            if (_removed[_objects[i]->denseId()])
+                continue;
+
+            allocations0 = AllocationCounter::count();
+            t0 = Clock::now();
+            index->update(_objects[i]);
+            updateNs += elapsedNs(t0);
+            allocations += AllocationCounter::count() - allocations0;
+            moved++;
+        }
+        allocations0 = AllocationCounter::count();
+        t0 = Clock::now();
+        index->rebuild();
+        updateNs += elapsedNs(t0);
+        allocations += AllocationCounter::count() - allocations0;
+
+        // rect queries (every other one category masked)
+        for (int q = 0; q < _config.rectQueries; q++)
+        {
+            RectF rect = randomRect(_config.querySize);
+            unsigned int mask = q % 2 ? randomMask() : ALL_CATEGORIES;
+            found.clear();
+            allocations0 = AllocationCounter::count();
+            t0 = Clock::now();
+            index->queryObjects(rect, found, mask);
+            rectQueryNs += elapsedNs(t0);
+            allocations += AllocationCounter::count() - allocations0;
+
+            _scene->objects(rect, expected, mask);
+            expected.erase(std::remove_if(expected.begin(), expected.end(), [&stored](Object* obj) { return !stored(obj); }), expected.end());
+            std::sort(found.begin(), found.end());
+            std::sort(expected.begin(), expected.end());
+            result.checks++;
+            if (found != expected)
+                mismatch(result, strprintf("rect query (%s, mask %x): %d objects instead of %d", rect.str().c_str(), mask, int(found.size()), int(expected.size())));
+        }
+
+        // raycasts
+        for (int r = 0; r < _config.raycasts; r++)
+        {
+            PointF start = randomRect(PointF(0, 0)).pos;
+            float angle = random(0, 6.2831853f);
+            LineF line(start.x, start.y, start.x + _config.rayLength * std::cos(angle), start.y + _config.rayLength * std::sin(angle));
+            hits.clear();
+            float tNear = 0;
+            allocations0 = AllocationCounter::count();
+            t0 = Clock::now();
+            index->raycast(line, hits);
+            Object* nearest = index->raycastNearest(line, tNear);
+            raycastNs += elapsedNs(t0);
+            allocations += AllocationCounter::count() - allocations0;
+
+            float tExpected = 0;
+            Object* expectedNearest = _scene->raycastNearest(line, tExpected, stored);
+            _scene->raycast(line, expectedHits);
+            expectedHits.erase(std::remove_if(expectedHits.begin(), expectedHits.end(), removedHit), expectedHits.end());
+            result.checks++;
+            if (hits.size() != expectedHits.size())
+                mismatch(result, strprintf("raycast: %d hits instead of %d", int(hits.size()), int(expectedHits.size())));
+            else if ((nearest != nullptr) != (expectedNearest != nullptr) || (nearest && tNear != tExpected))
+                mismatch(result, strprintf("raycast nearest: t = %f instead of %f", nearest ? tNear : -1.0f, expectedNearest ? tExpected : -1.0f));
+        }
+
+        // k-nearest queries (compared by distance, since ties can be reported in any order)
+        for (int q = 0; q < _config.nearestQueries; q++)
+        {
+            PointF point = randomRect(PointF(0, 0)).pos;
+            allocations0 = AllocationCounter::count();
+            t0 = Clock::now();
+            found = index->queryNearest(point, _config.nearestK);
+            nearestNs += elapsedNs(t0);
+            allocations += AllocationCounter::count() - allocations0;
+
+            expected = _scene->nearestObjects(point, _config.nearestK, stored);
+            bool same = found.size() == expected.size();
+            for (std::size_t i = 0; same && i < found.size(); i++)
+                same = found[i]->rect().distance(point) == expected[i]->rect().distance(point);
+            result.checks++;
+            if (!same)
+                mismatch(result, strprintf("k-nearest query (%s): %d objects, first at %f instead of %f", point.str().c_str(), int(found.size()),
+                    found.empty() ? -1.0f : found[0]->rect().distance(point), expected.empty() ? -1.0f : expected[0]->rect().distance(point)));
+        }
+
+        // broadphase (all pairs timed, then category masked)
+        if (_config.broadphase)
+        {
+            allocations0 = AllocationCounter::count();
+            t0 = Clock::now();
+            index->queryIntersections(pairs);
+            broadphaseNs += elapsedNs(t0);
+            allocations += AllocationCounter::count() - allocations0;
+
+            _scene->intersections(expectedPairs);
+            expectedPairs.erase(std::remove_if(expectedPairs.begin(), expectedPairs.end(), removedPair), expectedPairs.end());
+            result.checks++;
+            if (pairs != expectedPairs)
+                mismatch(result, strprintf("broadphase: %d pairs instead of %d", int(pairs.size()), int(expectedPairs.size())));
+
+            unsigned int categoryMask = randomMask();
+            unsigned int activeMask = randomMask();
+            pairs.clear();
+            index->queryIntersections(pairs, categoryMask, activeMask);
+            _scene->intersections(expectedPairs, categoryMask, activeMask);
+            expectedPairs.erase(std::remove_if(expectedPairs.begin(), expectedPairs.end(), removedPair), expectedPairs.end());
+            result.checks++;
+            if (pairs != expectedPairs)
+                mismatch(result, strprintf("broadphase (mask %x, active %x): %d pairs instead of %d", categoryMask, activeMask, int(pairs.size()), int(expectedPairs.size())));
+        }
+    }
+
+    index->clear();
+
+    result.updateNs = moved ? updateNs / moved : 0;
+    result.rectQueryNs = rectQueryNs / std::max(1, _config.steps * _config.rectQueries);
+    result.raycastNs = raycastNs / std::max(1, _config.steps * _config.raycasts);
+    result.nearestNs = nearestNs / std::max(1, _config.steps * _config.nearestQueries);
+    result.broadphaseNs = broadphaseNs / _config.steps;
+    result.allocations = double(allocations) / _config.steps;
+    return result;
+}
+
+void SpatialIndexBenchmark::printHeader()
+{
+    printf("%-20s %10s %10s %10s %10s %10s %12s %12s %10s\n", "index", "insert", "update", "rect", "raycast", "nearest", "broadphase", "allocs/step", "errors");
+}
+
+void SpatialIndexBenchmark::print(const Result& r)
+{
+    printf("%-20s %10.0f %10.0f %10.0f %10.0f %10.0f %12.0f %12.1f %10lld\n",
+        r.name.c_str(), r.insertNs, r.updateNs, r.rectQueryNs, r.raycastNs, r.nearestNs, r.broadphaseNs, r.allocations, r.mismatches);
+}
+
+std::vector<SpatialIndexBenchmark::Result> SpatialIndexBenchmark::runAll()
+{
+    printf("Spatial index benchmark: %d objects (%.0f%% large), %.0f%% moving, %.0f%% removed, %d steps\n",
+        _config.objects, _config.largeFraction * 100, _config.movingFraction * 100, _config.removedFraction * 100, _config.steps);
+
+    std::vector<std::pair<std::string, SpatialIndex*>> indices =
+    {
+        { "Quadtree", new Quadtree(_config.world) },
+        { "Quadtree (loose)", new Quadtree(_config.world, 1.5f) },
+        { "UniformGrid", new UniformGrid(_config.world, PointF(4, 4)) },
+        { "AABBTree", new AABBTree(_config.world) },
+        { "LinearQuadtree", new LinearQuadtree(_config.world) },
+        { "StaticIndex", new StaticIndex(_config.world) }
+    };
+
+    std::vector<Result> results;
+    printHeader();
+    for (auto& index : indices)
+    {
+        results.push_back(run(index.first, index.second));
+        print(results.back());
+        delete index.second;
+    }
+    printf("(ns per operation, heap allocations per step of timed operations, %lld checks per index against linear scanning)\n", results.empty() ? 0 : results[0].checks);
+
+    return results;
+}
+
+std::vector<SpatialIndexBenchmark::Result> SpatialIndexBenchmark::runGameScenes()
+{
+    printf("GameScene queries: Quadtree + StaticIndex (static category), immediate or deferred updates\n");
+
+    std::vector<std::pair<std::string, SpatialIndex*>> scenes =
+    {
+        { "GameScene", new GameSceneIndex(_config.world, _config.dt, STATIC_CATEGORY, false) },
+        { "GameScene (deferred)", new GameSceneIndex(_config.world, _config.dt, STATIC_CATEGORY, true) }
+    };
+
+    std::vector<Result> results;
+    printHeader();
+    for (auto& scene : scenes)
+    {
+        results.push_back(run(scene.first, scene.second));
+        print(results.back());
+        delete scene.second;
+    }
+    printf("(ns per operation, heap allocations per step of timed operations, %lld checks per scene against linear scanning)\n", results.empty() ? 0 : results[0].checks);
+
+    return results;
+}
@@ -0,0 +1,122 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include "geometryUtils.h"
+#include "SpatialIndex.h"
+
+namespace agp
+{
+    class Object;
+    class Scene;
+    class GameScene;
+    class SpatialIndex;
+    class SpatialIndexBenchmark;
+}
+
+// Spatial index benchmark class
+// - needs no window nor renderer: objects live in a plain Scene, whose
+//   (linear scan) queries are the reference results
+// - timed operations also count heap allocations (see AllocationCounter)
+// - N objects with configurable sizes (small + a fraction of large ones),
+//   a fraction of them moving (bouncing within the world)
+// - moving objects have one of two categories, the others STATIC_CATEGORY
+// - each step: a few objects removed (re-added the next step), update moved
+//   objects + rebuild, then rect queries (half of them category masked),
+//   raycasts, k-nearest queries and broadphase (all and category masked)
+// - every result is cross-checked against the Scene queries (mismatches are
+//   printed and counted), timings are reported in ns per operation
+// - all backends see the same objects, moves and queries (same random seed)
+// - runGameScenes() runs the same checks through GameScene queries (static
+//   categories in the static index, immediate or deferred index updates),
+//   which need a Game instance (offscreen rendering is enough)
+class agp::SpatialIndexBenchmark
+{
+    public:
+
+        struct Config
+        {
+            int objects = 10000;
+            RectF world = RectF(0, 0, 1000, 200);
+            PointF minSize = { 0.5f, 0.5f };
+            PointF maxSize = { 2, 2 };
+            float largeFraction = 0.01f;            // fraction of objects with large sizes
+            PointF largeSize = { 20, 10 };          // max size of large objects
+            float movingFraction = 0.5f;
+            float removedFraction = 0.01f;          // removed each step, re-added the next one
+            float maxSpeed = 10;                    // scene units per second
+            float dt = 1 / 60.0f;
+            int steps = 60;
+            int rectQueries = 200;                  // per step
+            PointF querySize = { 16, 12 };          // e.g. camera or AI sight
+            int raycasts = 50;                      // per step
+            float rayLength = 50;
+            int nearestQueries = 50;                // per step
+            int nearestK = 8;
+            bool broadphase = true;                 // once per step
+            unsigned int seed = 1;
+        };
+
+        struct Result
+        {
+            std::string name;
+            double insertNs = 0;        // per object
+            double updateNs = 0;        // per moved object (rebuild included)
+            double rectQueryNs = 0;     // per query
+            double raycastNs = 0;       // per raycast (all hits + nearest hit)
+            double nearestNs = 0;       // per k-nearest query
+            double broadphaseNs = 0;    // per broadphase query (all pairs)
+            double allocations = 0;     // heap allocations per step (timed operations, insert excluded)
+            long long checks = 0;
+            long long mismatches = 0;
+        };
+
+    private:
+
+        // parameters
+        static constexpr int MAX_REPORTED_MISMATCHES = 10;
+        static constexpr unsigned int STATIC_CATEGORY = 1 << 3;     // objects that never move
+
+        // attributes
+        Config _config;
+        Scene* _scene;                      // owned, reference (linear scan) queries
+        std::vector<Object*> _objects;
+        std::vector<RectF> _initialRects;   // restored before each run
+        std::vector<PointF> _velocities;    // (0,0) = static object
+        std::vector<bool> _removed;         // indexed by dense object id, out of the index under test
+        std::mt19937 _rng;
+
+        // helper functions
+        float random(float min, float max) { return std::uniform_real_distribution<float>(min, max)(_rng); }
+        RectF randomRect(const PointF& size);
+        void move(Object* obj, PointF& velocity);
+        unsigned int randomMask();
+        void mismatch(Result& result, const std::string& what);
+        static void printHeader();
+        static void print(const Result& r);
+
+    public:
+
+        SpatialIndexBenchmark();
+        SpatialIndexBenchmark(const Config& config);
+        ~SpatialIndexBenchmark();
+
+        // runs all workloads on the given (empty) index
+        Result run(const std::string& name, SpatialIndex* index);
+
+        // runs all workloads on every backend and prints a report
+        std::vector<Result> runAll();
+
+        // runs all workloads through GameScene queries and prints a report (needs a Game instance)
+        std::vector<Result> runGameScenes();
+};
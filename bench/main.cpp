@@ -0,0 +1,50 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "Game.h"
+#include "core_version.h"
+#include "SpatialIndexBenchmark.h"
+#include "CrowdBenchmark.h"
+
+// spatial index benchmark: bench [objects] [walkers]
+// - index backends on a plain Scene, then GameScene queries (offscreen game, no SDL video)
+// - crowd scenario (1000 HammerBrothers throwing hammers) on GameScenes with different indices
+// - exits with failure if any query result differs from linear scanning (or across scenes)
+int main(int argc, char *argv[])
+{
+	printf("Core v%s\n\n", agp::core::VERSION().c_str());
+
+	try
+	{
+		agp::SpatialIndexBenchmark::Config config;
+		if (argc > 1)
+			config.objects = std::atoi(argv[1]);
+		agp::SpatialIndexBenchmark benchmark(config);
+
+		long long mismatches = 0;
+		for (auto& result : benchmark.runAll())
+			mismatches += result.mismatches;
+
+		agp::Game::setInstance(new agp::Game("bench", agp::Point(600, 600), 1, agp::Game::Rendering::OFFSCREEN));
+		for (auto& result : benchmark.runGameScenes())
+			mismatches += result.mismatches;
+
+		agp::CrowdBenchmark::Config crowdConfig;
+		if (argc > 2)
+			crowdConfig.walkers = std::atoi(argv[2]);
+		for (auto& result : agp::CrowdBenchmark(crowdConfig).runAll())
+			mismatches += result.mismatches;
+
+		return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+	catch (const char* errMsg)
+	{
+		printf("ERROR: %s\n", errMsg);
+	}
+	catch (std::string errMsg)
+	{
+		printf("ERROR: %s\n", errMsg.c_str());
+	}
+
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,678 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "AABBTree.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <iostream>
+#include "Object.h"
+#include "ThreadPool.h"
+
+using namespace agp;
+
+AABBTree::Box AABBTree::Box::merge(const Box& b) const
+{
+    return Box(
+        PointF(std::min(min.x, b.min.x), std::min(min.y, b.min.y)),
+        PointF(std::max(max.x, b.max.x), std::max(max.y, b.max.y)));
+}
+
+bool AABBTree::Box::intersectsLine(const LineF& line, float& tEnter) const
+{
+    float tExit;
+    return RectF(min, max).intersectsLine(line.start, line.end, tEnter, tExit);
+}
+
+AABBTree::AABBTree(const RectF& rect, float margin) :
+    _rect(rect)
+{
+    if (margin < 0)
+        throw "AABBTree::AABBTree: margin must be >= 0";
+
+    _margin = margin;
+    _root = -1;
+    _freeList = -1;
+}
+
+void AABBTree::clear()
+{
+    _nodes.clear();
+    _root = -1;
+    _freeList = -1;
+    std::fill(_objectToLeaf.begin(), _objectToLeaf.end(), ObjectEntry());
+}
+
+void AABBTree::add(Object* obj)
+{
+    if (!_rect.contains(obj->rect()))
+    {
+        if (VERBOSE)
+            std::cerr << strprintf("AABBTree::add: tree rect (%s) does not fully contain object (%s) rect (%s)", _rect.str().c_str(), obj->name().c_str(), obj->rect().str().c_str());
+        return;
+    }
+
+    if (obj->denseId() >= int(_objectToLeaf.size()))
+        _objectToLeaf.resize(std::max(std::size_t(obj->denseId() + 1), 2 * _objectToLeaf.size()));
+
+    if (_objectToLeaf[obj->denseId()].leaf != -1)
+    {
+        if (VERBOSE)
+            std::cerr << "AABBTree::add: trying to add an object already present in the tree\n";
+        return;
+    }
+
+    int leaf = allocateNode();
+    _nodes[leaf].obj = obj;
+    _nodes[leaf].box = fatBox(obj->rect(), PointF(0, 0));
+    _nodes[leaf].categories = obj->category();
+    insertLeaf(leaf);
+
+    _objectToLeaf[obj->denseId()].leaf = leaf;
+    _objectToLeaf[obj->denseId()].lastPos = obj->rect().pos;
+}
+
+void AABBTree::remove(Object* obj)
+{
+    ObjectEntry* e = entry(obj);
+    if (!e || e->leaf == -1)
+        return;
+
+    removeLeaf(e->leaf);
+    freeNode(e->leaf);
+    e->leaf = -1;
+}
+
+void AABBTree::update(Object* obj)
+{
+    ObjectEntry* e = entry(obj);
+    if (!e || e->leaf == -1)
+    {
+        if (VERBOSE)
+            std::cerr << "AABBTree::update: trying to update an object [" << obj->name() << ", rect = " << obj->rect().str() << "] that is not present in the tree\n";
+        return;
+    }
+
+    if (!_rect.contains(obj->rect()))
+    {
+        remove(obj);
+        return;
+    }
+
+    PointF displacement = obj->rect().pos - e->lastPos;
+    e->lastPos = obj->rect().pos;
+
+    // fast path: the object is still inside its fat box, and the fat box
+    // is not oversized (e.g. left over from a previous fast movement)
+    Box newFatBox = fatBox(obj->rect(), displacement);
+    const Box& oldFatBox = _nodes[e->leaf].box;
+    if (oldFatBox.contains(Box(obj->rect())))
+    {
+        float hugeMargin = 4 * _margin;
+        Box hugeBox(newFatBox.min - PointF(hugeMargin, hugeMargin), newFatBox.max + PointF(hugeMargin, hugeMargin));
+        if (hugeBox.contains(oldFatBox))
+        {
+            // the category might have changed: fix the masks up to the root
+            if (_nodes[e->leaf].categories != obj->category())
+            {
+                _nodes[e->leaf].categories = obj->category();
+                for (int node = _nodes[e->leaf].parent; node != -1; node = _nodes[node].parent)
+                    _nodes[node].categories = _nodes[_nodes[node].child1].categories | _nodes[_nodes[node].child2].categories;
+            }
+            return;
+        }
+    }
+
+    removeLeaf(e->leaf);
+    _nodes[e->leaf].box = newFatBox;
+    _nodes[e->leaf].categories = obj->category();
+    insertLeaf(e->leaf);
+}
+
+void AABBTree::queryObjects(const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const
+{
+    if (_root == -1)
+        return;
+
+    Box queryBox(queryRect);
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = _root;
+    while (stackSize)
+    {
+        int node = stack[--stackSize];
+
+        const Node& n = _nodes[node];
+        if (!(n.categories & categoryMask) || !n.box.overlaps(queryBox))
+            continue;
+
+        if (isLeaf(node))
+        {
+            if (queryRect.intersects(n.obj->rect()) && !visitor(n.obj))
+                return;
+        }
+        else
+        {
+            stack[stackSize++] = n.child1;
+            stack[stackSize++] = n.child2;
+        }
+    }
+}
+
+void AABBTree::queryIntersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    pairs.clear();
+
+    _leaves.clear();
+    for (int i = 0; i < int(_nodes.size()); i++)
+        if (_nodes[i].height == 0 && (_nodes[i].categories & categoryMask))
+            _leaves.push_back(i);
+
+    // chunks of leaves are independent tasks, each filling its own buffer
+    int tasks = (int(_leaves.size()) + LEAVES_PER_TASK - 1) / LEAVES_PER_TASK;
+    if (_taskPairs.size() < std::size_t(tasks))
+        _taskPairs.resize(tasks);
+
+    ThreadPool::instance()->parallelFor(tasks, [&](int t)
+        {
+            _taskPairs[t].clear();
+            std::size_t end = std::min(_leaves.size(), std::size_t(t + 1) * LEAVES_PER_TASK);
+            for (std::size_t i = std::size_t(t) * LEAVES_PER_TASK; i < end; i++)
+                leafIntersections(_leaves[i], _taskPairs[t], categoryMask, activeMask);
+        });
+
+    for (int t = 0; t < tasks; t++)
+        pairs.insert(pairs.end(), _taskPairs[t].begin(), _taskPairs[t].end());
+    sortPairs(pairs);
+}
+
+void AABBTree::leafIntersections(int leaf, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    Object* obj = _nodes[leaf].obj;
+    const Box& leafBox = _nodes[leaf].box;
+
+    // an inactive object only pairs with active ones
+    unsigned int otherMask = (obj->category() & activeMask) ? ALL_CATEGORIES : activeMask;
+
+    // each pair is found from both leaves, and kept from the lower id side
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = _root;
+    while (stackSize)
+    {
+        int node = stack[--stackSize];
+
+        const Node& n = _nodes[node];
+        if (!(n.categories & categoryMask) || !(n.categories & otherMask) || !n.box.overlaps(leafBox))
+            continue;
+
+        if (isLeaf(node))
+        {
+            if (n.obj->id() > obj->id() && obj->rect().intersects(n.obj->rect()))
+                pairs.emplace_back(obj, n.obj);
+        }
+        else
+        {
+            stack[stackSize++] = n.child1;
+            stack[stackSize++] = n.child2;
+        }
+    }
+}
+
+void AABBTree::raycast(const LineF& line, RaycastHits& hits) const
+{
+    if (_root == -1)
+        return;
+
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = _root;
+    float tHit;
+    while (stackSize)
+    {
+        int node = stack[--stackSize];
+
+        const Node& n = _nodes[node];
+        if (!n.box.intersectsLine(line, tHit))
+            continue;
+
+        if (isLeaf(node))
+        {
+            if (n.obj->intersectsLine(line, tHit))
+                hits.emplace_back(n.obj, tHit);
+        }
+        else
+        {
+            stack[stackSize++] = n.child1;
+            stack[stackSize++] = n.child2;
+        }
+    }
+}
+
+Object* AABBTree::raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter) const
+{
+    if (_root == -1)
+        return nullptr;
+
+    Object* nearest = nullptr;
+    float tBest = std::numeric_limits<float>::infinity();
+
+    // stack of (node, entry time), nearest child pushed last so that it is visited first
+    std::pair<int, float> stack[STACK_SIZE];
+    int stackSize = 0;
+    float tEnter;
+    if (_nodes[_root].box.intersectsLine(line, tEnter))
+        stack[stackSize++] = { _root, tEnter };
+    while (stackSize)
+    {
+        auto top = stack[--stackSize];
+        if (top.second >= tBest)
+            continue;
+
+        const Node& n = _nodes[top.first];
+        if (isLeaf(top.first))
+        {
+            float tHit;
+            if (n.obj->intersectsLine(line, tHit) && tHit < tBest && (!filter || filter(n.obj)))
+            {
+                nearest = n.obj;
+                tBest = tHit;
+            }
+        }
+        else
+        {
+            float t1, t2;
+            bool hit1 = _nodes[n.child1].box.intersectsLine(line, t1) && t1 < tBest;
+            bool hit2 = _nodes[n.child2].box.intersectsLine(line, t2) && t2 < tBest;
+            if (hit1 && hit2)
+            {
+                if (t1 < t2)
+                {
+                    stack[stackSize++] = { n.child2, t2 };
+                    stack[stackSize++] = { n.child1, t1 };
+                }
+                else
+                {
+                    stack[stackSize++] = { n.child1, t1 };
+                    stack[stackSize++] = { n.child2, t2 };
+                }
+            }
+            else if (hit1)
+                stack[stackSize++] = { n.child1, t1 };
+            else if (hit2)
+                stack[stackSize++] = { n.child2, t2 };
+        }
+    }
+
+    if (nearest)
+        tNear = tBest;
+    return nearest;
+}
+
+std::vector<Object*> AABBTree::queryNearest(const PointF& point, int k, const ObjectFilter& filter, float maxDistance) const
+{
+    NearestCandidates nearest(k, maxDistance);
+    if (k <= 0 || _root == -1)
+        return nearest.sorted();
+
+    // best-first: nodes are visited by increasing distance from the point,
+    // until the nearest unvisited node is farther than the k-th candidate
+    typedef std::pair<float, int> NodeDistance;
+    std::priority_queue<NodeDistance, std::vector<NodeDistance>, std::greater<NodeDistance>> frontier;
+    frontier.emplace(_nodes[_root].box.distance(point), _root);
+    while (!frontier.empty())
+    {
+        NodeDistance top = frontier.top();
+        frontier.pop();
+        if (top.first > nearest.bound())
+            break;
+
+        const Node& n = _nodes[top.second];
+        if (isLeaf(top.second))
+            nearest.add(n.obj, n.obj->rect().distance(point), filter);
+        else
+        {
+            for (int child : { n.child1, n.child2 })
+            {
+                float distance = _nodes[child].box.distance(point);
+                if (distance <= nearest.bound())
+                    frontier.emplace(distance, child);
+            }
+        }
+    }
+
+    return nearest.sorted();
+}
+
+std::vector<Object*> AABBTree::queryRadius(const PointF& point, float radius, const ObjectFilter& filter) const
+{
+    auto objects = std::vector<Object*>();
+    if (_root == -1)
+        return objects;
+
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = _root;
+    while (stackSize)
+    {
+        int node = stack[--stackSize];
+
+        const Node& n = _nodes[node];
+        if (n.box.distance(point) > radius)
+            continue;
+
+        if (isLeaf(node))
+        {
+            if (n.obj->rect().distance(point) <= radius && (!filter || filter(n.obj)))
+                objects.push_back(n.obj);
+        }
+        else
+        {
+            stack[stackSize++] = n.child1;
+            stack[stackSize++] = n.child2;
+        }
+    }
+
+    return objects;
+}
+
+int AABBTree::allocateNode()
+{
+    int node;
+    if (_freeList != -1)
+    {
+        node = _freeList;
+        _freeList = _nodes[node].parent;
+    }
+    else
+    {
+        // might reallocate the pool: callers must not hold Node references across this call
+        node = int(_nodes.size());
+        _nodes.emplace_back();
+    }
+
+    _nodes[node] = Node();
+    return node;
+}
+
+void AABBTree::freeNode(int node)
+{
+    _nodes[node].obj = nullptr;
+    _nodes[node].child1 = _nodes[node].child2 = -1;
+    _nodes[node].height = -1;
+    _nodes[node].parent = _freeList;
+    _freeList = node;
+}
+
+AABBTree::Box AABBTree::fatBox(const RectF& rect, const PointF& displacement) const
+{
+    Box box(rect.pos - PointF(_margin, _margin), rect.pos + rect.size + PointF(_margin, _margin));
+
+    // predictive extension along the movement direction
+    PointF d(displacement.x * DISPLACEMENT_MULTIPLIER, displacement.y * DISPLACEMENT_MULTIPLIER);
+    if (d.x < 0)
+        box.min.x += d.x;
+    else
+        box.max.x += d.x;
+    if (d.y < 0)
+        box.min.y += d.y;
+    else
+        box.max.y += d.y;
+
+    return box;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+    if (_root == -1)
+    {
+        _root = leaf;
+        _nodes[leaf].parent = -1;
+        return;
+    }
+
+    // find the best sibling: descend while the cost of pairing with
+    // a child (plus the enlargement inherited by ancestors) is lower
+    Box leafBox = _nodes[leaf].box;
+    int index = _root;
+    while (!isLeaf(index))
+    {
+        int child1 = _nodes[index].child1;
+        int child2 = _nodes[index].child2;
+
+        float perimeter = _nodes[index].box.perimeter();
+        float combinedPerimeter = _nodes[index].box.merge(leafBox).perimeter();
+
+        // cost of creating a new parent for this node and the new leaf
+        float cost = 2 * combinedPerimeter;
+
+        // minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2 * (combinedPerimeter - perimeter);
+
+        auto descendCost = [&](int child)
+        {
+            float newPerimeter = _nodes[child].box.merge(leafBox).perimeter();
+            if (isLeaf(child))
+                return newPerimeter + inheritanceCost;
+            else
+                return newPerimeter - _nodes[child].box.perimeter() + inheritanceCost;
+        };
+        float cost1 = descendCost(child1);
+        float cost2 = descendCost(child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+    int sibling = index;
+
+    // create a new parent for the sibling and the leaf
+    int oldParent = _nodes[sibling].parent;
+    int newParent = allocateNode();
+    _nodes[newParent].parent = oldParent;
+    _nodes[newParent].box = leafBox.merge(_nodes[sibling].box);
+    _nodes[newParent].height = _nodes[sibling].height + 1;
+    _nodes[newParent].categories = _nodes[sibling].categories | _nodes[leaf].categories;
+    _nodes[newParent].child1 = sibling;
+    _nodes[newParent].child2 = leaf;
+    _nodes[sibling].parent = newParent;
+    _nodes[leaf].parent = newParent;
+
+    if (oldParent != -1)
+    {
+        if (_nodes[oldParent].child1 == sibling)
+            _nodes[oldParent].child1 = newParent;
+        else
+            _nodes[oldParent].child2 = newParent;
+    }
+    else
+        _root = newParent;
+
+    // walk back up fixing heights and boxes
+    refit(_nodes[leaf].parent);
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+    if (leaf == _root)
+    {
+        _root = -1;
+        return;
+    }
+
+    int parent = _nodes[leaf].parent;
+    int grandParent = _nodes[parent].parent;
+    int sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+    // replace the parent with the sibling
+    if (grandParent != -1)
+    {
+        if (_nodes[grandParent].child1 == parent)
+            _nodes[grandParent].child1 = sibling;
+        else
+            _nodes[grandParent].child2 = sibling;
+        _nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        refit(grandParent);
+    }
+    else
+    {
+        _root = sibling;
+        _nodes[sibling].parent = -1;
+        freeNode(parent);
+    }
+}
+
+void AABBTree::refit(int node)
+{
+    while (node != -1)
+    {
+        node = balance(node);
+
+        Node& n = _nodes[node];
+        n.height = 1 + std::max(_nodes[n.child1].height, _nodes[n.child2].height);
+        n.box = _nodes[n.child1].box.merge(_nodes[n.child2].box);
+        n.categories = _nodes[n.child1].categories | _nodes[n.child2].categories;
+
+        node = n.parent;
+    }
+}
+
+int AABBTree::balance(int iA)
+{
+    // rotates the taller grandchild subtree up when children heights differ by more than 1
+    Node& A = _nodes[iA];
+    if (isLeaf(iA) || A.height < 2)
+        return iA;
+
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = _nodes[iB];
+    Node& C = _nodes[iC];
+
+    int diff = C.height - B.height;
+
+    // rotate C up
+    if (diff > 1)
+    {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = _nodes[iF];
+        Node& G = _nodes[iG];
+
+        // swap A and C
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        // A's old parent should point to C
+        if (C.parent != -1)
+        {
+            if (_nodes[C.parent].child1 == iA)
+                _nodes[C.parent].child1 = iC;
+            else
+                _nodes[C.parent].child2 = iC;
+        }
+        else
+            _root = iC;
+
+        // the taller of F and G stays under C, the other moves under A
+        if (F.height > G.height)
+        {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = B.box.merge(G.box);
+            C.box = A.box.merge(F.box);
+            A.categories = B.categories | G.categories;
+            C.categories = A.categories | F.categories;
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else
+        {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = B.box.merge(F.box);
+            C.box = A.box.merge(G.box);
+            A.categories = B.categories | F.categories;
+            C.categories = A.categories | G.categories;
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+
+        return iC;
+    }
+
+    // rotate B up
+    if (diff < -1)
+    {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = _nodes[iD];
+        Node& E = _nodes[iE];
+
+        // swap A and B
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        // A's old parent should point to B
+        if (B.parent != -1)
+        {
+            if (_nodes[B.parent].child1 == iA)
+                _nodes[B.parent].child1 = iB;
+            else
+                _nodes[B.parent].child2 = iB;
+        }
+        else
+            _root = iB;
+
+        // the taller of D and E stays under B, the other moves under A
+        if (D.height > E.height)
+        {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = C.box.merge(E.box);
+            B.box = A.box.merge(D.box);
+            A.categories = C.categories | E.categories;
+            B.categories = A.categories | D.categories;
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else
+        {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = C.box.merge(D.box);
+            B.box = A.box.merge(E.box);
+            A.categories = C.categories | D.categories;
+            B.categories = A.categories | E.categories;
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+AABBTree::ObjectEntry* AABBTree::entry(const Object* obj)
+{
+    if (obj->denseId() < 0 || obj->denseId() >= int(_objectToLeaf.size()))
+        return nullptr;
+
+    return &_objectToLeaf[obj->denseId()];
+}
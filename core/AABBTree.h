@@ -0,0 +1,122 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+
+#pragma once
+
+#include <vector>
+#include "geometryUtils.h"
+#include "SpatialIndex.h"
+
+namespace agp
+{
+    class Object;
+    class AABBTree;
+}
+
+// Dynamic AABB tree (or bounding volume hierarchy) class
+// - container for game objects stored as leaves of a binary tree, each internal
+//   node storing the box enclosing its two children
+// - leaves store fat boxes: object rect enlarged by a margin and extended along
+//   the last displacement, so that update() is O(1) until the object leaves its fat box
+// - insertion picks the sibling with the lowest perimeter cost, and the tree is kept
+//   balanced by AVL-like rotations while walking back to the root
+// - raycasts descend only into boxes crossed by the line, nearest child first
+// - k-nearest queries visit nodes best-first (by distance from the query point)
+// - no depth limit and no dependency on the object distribution: suited for scenes
+//   with many fast moving objects
+// - nodes live in a pool (recycled via free list)
+// - object-to-leaf lookup is a flat table indexed by dense object id (see Object::denseId)
+// - each node keeps the OR of the object categories in its subtree, so that
+//   queries with a category mask skip whole subtrees
+// - broadphase queries the tree with each leaf box, chunks of leaves in parallel
+class agp::AABBTree : public SpatialIndex
+{
+    private:
+
+        // parameters
+        static constexpr float DISPLACEMENT_MULTIPLIER = 4;    // predictive extension of fat boxes
+        static constexpr int STACK_SIZE = 256;                 // traversal stack, way above the height of a balanced tree
+        static constexpr int LEAVES_PER_TASK = 64;             // broadphase leaves processed by each parallel task
+        static constexpr bool VERBOSE = false;
+
+        // inner classes/structs
+        struct Box
+        {
+            PointF min, max;
+            Box() {}
+            Box(const PointF& minCorner, const PointF& maxCorner) : min(minCorner), max(maxCorner) {}
+            Box(const RectF& r) : min(r.pos), max(r.pos + r.size) {}
+            bool contains(const Box& b) const { return min.x <= b.min.x && min.y <= b.min.y && max.x >= b.max.x && max.y >= b.max.y; }
+            bool overlaps(const Box& b) const { return min.x <= b.max.x && max.x >= b.min.x && min.y <= b.max.y && max.y >= b.min.y; }
+            float perimeter() const { return 2 * (max.x - min.x + max.y - min.y); }
+            Box merge(const Box& b) const;
+            bool intersectsLine(const LineF& line, float& tEnter) const;
+            float distance(const PointF& p) const { return RectF(min, max).distance(p); }
+        };
+        struct Node
+        {
+            Box box;                // fat box (leaves) or enclosing box (internal nodes)
+            Object* obj = nullptr;  // leaves only
+            int parent = -1;        // also next free node when in the free list
+            int child1 = -1;        // -1 = leaf
+            int child2 = -1;
+            int height = 0;         // leaf = 0, free = -1
+            unsigned int categories = 0;    // object category (leaves) or OR of children categories
+        };
+        struct ObjectEntry
+        {
+            int leaf = -1;          // index of the leaf storing the object (-1 = not stored)
+            PointF lastPos;         // position at the last update, to estimate displacement
+        };
+
+        // attributes
+        RectF _rect;
+        float _margin;
+        int _root;
+        std::vector<Node> _nodes;               // node pool
+        int _freeList;                          // first free node (-1 = none)
+        std::vector<ObjectEntry> _objectToLeaf; // indexed by dense object id
+        mutable std::vector<int> _leaves;               // broadphase leaves, reused across queries
+        mutable std::vector<ObjectPairs> _taskPairs;    // one broadphase buffer per task, reused across queries
+
+        // helper functions
+        bool isLeaf(int node) const { return _nodes[node].child1 == -1; }
+        int allocateNode();
+        void freeNode(int node);
+        Box fatBox(const RectF& rect, const PointF& displacement) const;
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int node);
+        void refit(int node);
+        ObjectEntry* entry(const Object* obj);
+        void leafIntersections(int leaf, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+
+    public:
+
+        AABBTree(const RectF& rect, float margin = 0.1f);
+        virtual RectF rect() const override { return _rect; }
+        float margin() const { return _margin; }
+
+        virtual void add(Object* obj) override;
+        virtual void remove(Object* obj) override;
+        virtual void update(Object* obj) override;
+        virtual void clear() override;
+
+        using SpatialIndex::queryObjects;
+        virtual void queryObjects(const RectF& rect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) const override;
+        virtual void raycast(const LineF& line, RaycastHits& hits) const override;
+        virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) const override;
+        virtual std::vector<Object*> queryNearest(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) const override;
+        virtual std::vector<Object*> queryRadius(const PointF& point, float radius, const ObjectFilter& filter = nullptr) const override;
+        virtual void queryIntersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const override;
+
+        // debugging
+        int height() const { return _root == -1 ? 0 : _nodes[_root].height; }
+};
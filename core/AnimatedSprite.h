@@ -19,7 +19,8 @@ namespace agp
 
 // AnimatedSprite
 // - implements animations
-class agp::AnimatedSprite : public Sprite
+// - pooled allocation (own pool, see Sprite)
+class agp::AnimatedSprite : public Sprite, public Pooled<AnimatedSprite>
 {
 	protected:
 
@@ -33,6 +34,9 @@ class agp::AnimatedSprite : public Sprite
 
 	public:
 
+		using Pooled<AnimatedSprite>::operator new;
+		using Pooled<AnimatedSprite>::operator delete;
+
 		AnimatedSprite(
 			SDL_Texture* spritesheet,
 			const std::vector<RectI>& frames,
@@ -50,6 +54,7 @@ class agp::AnimatedSprite : public Sprite
 
 		// extends update method (+animations)
 		virtual void update(float dt) override;
+		virtual bool animated() const override { return true; }
 
 		// extends reset method (+restart frameIterator )
 		virtual void reset() override;
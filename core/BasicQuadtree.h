@@ -0,0 +1,1039 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <iostream>
+#include "geometryUtils.h"
+#include "stringUtils.h"
+#include "SpatialIndex.h"
+#include "ThreadPool.h"
+
+namespace agp
+{
+    template <typename T, typename Traits, int MaxObjectsPerNode = 16, int MaxDepth = 8>
+    class BasicQuadtree;
+}
+
+// Quadtree (standard/scrict or loose) template
+// - container for any payload type T (e.g. Object*, editor handles, particles, obstacles),
+//   see Quadtree for the Object* spatial index used by game scenes
+// - Traits provides the payload accessors as static functions (inlined in hot paths):
+//      const RectF& rect(const T&)                      bounds
+//      int id(const T&)                                 unique id (pair and tie order)
+//      int denseId(const T&)                            id >= 0 unique among stored objects, reused once
+//                                                       they are gone (object-to-node table)
+//      unsigned int category(const T&)                  category bitmask (return 1 if unused)
+//      bool intersectsLine(const T&, const LineF&, float& tHit)
+// - node capacity and max depth are compile-time parameters
+// - objects are stored in the smallest node that entirely contains its rect
+// - loose mode: node bounds are enlarged by the looseness factor and objects
+//   descend into the child containing their center, so that objects straddling
+//   quadrant borders do not pile up in upper nodes
+// - update() is O(1) when the object still fits in its current node
+// - queries take any callable (visitors, filters), so they are inlined too
+// - raycasts visit only the nodes crossed by the line, front-to-back for nearest queries
+// - k-nearest queries visit nodes best-first (by distance from the query point)
+// - broadphase: objects are tested against objects in the same node and in descendants,
+//   plus (loose) objects in sibling subtrees whose loose bounds overlap; subtrees are
+//   pruned by their (loose) bounds, upper nodes and subtrees are parallel tasks
+// - nodes live in a pool (siblings allocated in blocks of 4, recycled via free list)
+// - under-populated subtrees are collapsed automatically after remove/update
+// - bulkLoad() builds the whole tree top-down in one pass (no splits and
+//   redistributions): objects are partitioned by quadrant with a counting sort
+//   and each node gets its objects with exact capacity
+// - object-to-node lookup is a flat table indexed by dense id (sized by the stored objects)
+// - each node keeps the OR of the object categories in its subtree, so that
+//   queries with a category mask skip whole subtrees
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+class agp::BasicQuadtree
+{
+    public:
+
+        typedef std::vector<std::pair<T, float>> Hits;  // (object, hit time along the line)
+        typedef std::vector<std::pair<T, T>> Pairs;     // (lower id object, higher id object)
+
+        // accepts all objects (default filter)
+        struct AcceptAll { bool operator()(const T&) const { return true; } };
+
+    private:
+
+        // parameters
+        static constexpr int MAX_OBJECTS_PER_NODE = MaxObjectsPerNode;
+        static constexpr int MAX_DEPTH = MaxDepth;
+        static constexpr int PARALLEL_DEPTH = 2;    // subtrees rooted at this depth are broadphase tasks
+        static constexpr bool VERBOSE = false;
+
+        // inner classes/structs
+        struct Node
+        {
+            int children = -1;              // index of the first child in the pool (-1 = leaf), siblings are contiguous
+            int parent = -1;                // index of the parent in the pool (-1 = root)
+            RectF rect;                     // (strict) node rect
+            unsigned int categories = 0;    // OR of the object categories in the subtree
+                                            // (superset: stale bits are cleared on removal)
+            std::vector<T> objects;
+        };
+        struct ObjectEntry
+        {
+            int node = -1;      // index of the node storing the object (-1 = not stored)
+            int slot = -1;      // index of the object within node's objects
+        };
+        typedef std::pair<T, RectF> BulkItem;   // object rects are copied once for cache-friendly passes
+
+        // attributes
+        RectF _rect;
+        float _looseness;                       // node bounds scale factor (1 = strict)
+        std::vector<Node> _nodes;               // node pool, root is _nodes[0]
+        std::vector<int> _freeBlocks;           // first indices of unused sibling blocks
+        std::vector<ObjectEntry> _objectToNode; // indexed by dense id
+        mutable std::vector<std::pair<int, bool>> _intersectionTasks;  // (node, whole subtree), reused across queries
+        mutable std::vector<Pairs> _taskPairs;                          // one buffer per task, reused across queries
+
+        // helper functions
+        bool isLeaf(int node) const { return _nodes[node].children == -1; }
+        RectF indexToQuadrant(const RectF& rect, int i) const;
+        RectF looseRect(const RectF& rect) const;
+        int getObjectQuadrant(const RectF& quadRect, const RectF& objRect) const;
+        void add(int node, std::size_t depth, const RectF& nodeRect, const T& obj);
+        void split(int node, const RectF& nodeRect);
+        void build(int node, int depth, const RectF& nodeRect, std::vector<BulkItem>& items, int begin, int end,
+            std::vector<int>& quadrants, std::vector<BulkItem>& buffer);
+        int allocateChildren(int parent, const RectF& parentRect);
+        void freeChildren(int node);
+        void nodeAddObject(int node, const T& obj);
+        void nodeRemoveObject(int node, const T& obj);
+        void addCategories(int node, unsigned int categories);
+        void refreshCategories(int node);
+        bool tryMerge(int node);
+        void mergeUpwards(int node);
+        ObjectEntry* entry(const T& obj);
+        template <typename Visitor>
+        bool query(int node, const RectF& nodeRect, const RectF& queryRect, Visitor& visitor, unsigned int categoryMask) const;
+        void collectIntersectionTasks(int node, int depth) const;
+        void queryIntersections(int node, Pairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+        void nodeIntersections(int node, Pairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+        void raycast(int node, const LineF& line, Hits& hits) const;
+        template <typename Filter>
+        void raycastNearest(int node, const LineF& line, Filter& filter, const T*& nearest, float& tNear) const;
+        template <typename Filter>
+        void queryRadius(int node, const PointF& point, float radius, Filter& filter, std::vector<T>& objects) const;
+        void queryIntersectionsInDescendants(int node, const T& obj, Pairs& pairs, unsigned int categoryMask, unsigned int otherMask) const;
+        void crossIntersections(int a, int b, Pairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+
+    public:
+
+        BasicQuadtree(const RectF& rect, float looseness = 1);
+        RectF rect() const { return _rect; }
+        float looseness() const { return _looseness; }
+        void setLooseness(float looseness);
+
+        void add(const T& obj);
+        void remove(const T& obj);
+        void update(const T& obj);
+        void clear();
+        void bulkLoad(const std::vector<T>& objects);
+
+        // rect query: the visitor is called once per object intersecting the rect until it returns false
+        template <typename Visitor>
+        void queryObjects(const RectF& rect, Visitor&& visitor, unsigned int categoryMask = ALL_CATEGORIES) const;
+
+        // raycast: hit times are in [0,1] along the line
+        // - all hits are appended to 'hits' in no particular order
+        // - nearest hit among the objects accepted by the filter, nullptr if none
+        //   (points into the tree, valid until the next change)
+        void raycast(const LineF& line, Hits& hits) const;
+        template <typename Filter = AcceptAll>
+        const T* raycastNearest(const LineF& line, float& tNear, Filter filter = Filter()) const;
+
+        // proximity queries (distance from the point to the object rect)
+        // - k nearest objects (within maxDistance) accepted by the filter, sorted by increasing distance
+        // - objects within the given distance accepted by the filter, in no particular order
+        template <typename Filter = AcceptAll>
+        std::vector<T> queryNearest(const PointF& point, int k, Filter filter = Filter(), float maxDistance = std::numeric_limits<float>::infinity()) const;
+        template <typename Filter = AcceptAll>
+        std::vector<T> queryRadius(const PointF& point, float radius, Filter filter = Filter()) const;
+
+        // broadphase: all pairs of intersecting objects, each reported once
+        // - only objects matching categoryMask, at least one of the two matching activeMask
+        // - pairs are sorted by object ids, so results do not depend on traversal or threads order
+        void queryIntersections(Pairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const;
+
+        // debugging
+        std::size_t nodesCount() const { return _nodes.size() - 4 * _freeBlocks.size(); }
+};
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::BasicQuadtree(const RectF& rect, float looseness) :
+    _rect(rect)
+{
+    if (looseness < 1)
+        throw "BasicQuadtree::BasicQuadtree: looseness must be >= 1";
+
+    _looseness = looseness;
+    _nodes.emplace_back();
+    _nodes[0].rect = _rect;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::setLooseness(float looseness)
+{
+    if (looseness < 1)
+        throw "BasicQuadtree::setLooseness: looseness must be >= 1";
+
+    if (looseness == _looseness)
+        return;
+
+    // collect stored objects and insert them again with the new node bounds
+    std::vector<T> objects;
+    for (const auto& node : _nodes)
+        objects.insert(objects.end(), node.objects.begin(), node.objects.end());
+    clear();
+    _looseness = looseness;
+    bulkLoad(objects);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::clear()
+{
+    for (auto& node : _nodes)
+        for (const auto& obj : node.objects)
+            _objectToNode[Traits::denseId(obj)] = ObjectEntry();
+
+    _nodes.resize(1);
+    _nodes[0].children = -1;
+    _nodes[0].categories = 0;
+    _nodes[0].objects.clear();
+    _freeBlocks.clear();
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::bulkLoad(const std::vector<T>& objects)
+{
+    // stored objects are loaded again together with the new ones
+    std::vector<T> all;
+    for (const auto& node : _nodes)
+        all.insert(all.end(), node.objects.begin(), node.objects.end());
+    std::size_t stored = all.size();
+    int maxDenseId = -1;
+    for (const auto& obj : objects)
+    {
+        if (!_rect.contains(Traits::rect(obj)))
+        {
+            if (VERBOSE)
+                std::cerr << strprintf("BasicQuadtree::bulkLoad: quadtree rect (%s) does not fully contain object rect (%s)\n", _rect.str().c_str(), Traits::rect(obj).str().c_str());
+            continue;
+        }
+        ObjectEntry* e = entry(obj);
+        if (e && e->node != -1)
+        {
+            if (VERBOSE)
+                std::cerr << "BasicQuadtree::bulkLoad: trying to add an object already present in the quadtree\n";
+            continue;
+        }
+        all.push_back(obj);
+        maxDenseId = std::max(maxDenseId, Traits::denseId(obj));
+    }
+    if (all.size() == stored)
+        return;
+
+    clear();
+    if (maxDenseId >= int(_objectToNode.size()))
+        _objectToNode.resize(maxDenseId + 1);
+
+    std::vector<BulkItem> items, buffer(all.size());
+    items.reserve(all.size());
+    for (const auto& obj : all)
+        items.emplace_back(obj, Traits::rect(obj));
+    std::vector<int> quadrants(all.size());
+    build(0, 0, _rect, items, 0, int(items.size()), quadrants, buffer);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::add(const T& obj)
+{
+    if (!_rect.contains(Traits::rect(obj)))
+    {
+        if (VERBOSE)
+            std::cerr << strprintf("BasicQuadtree::add: quadtree rect (%s) does not fully contain object rect (%s)\n", _rect.str().c_str(), Traits::rect(obj).str().c_str());
+        return;
+    }
+
+    add(0, 0, _rect, obj);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::remove(const T& obj)
+{
+    ObjectEntry* e = entry(obj);
+    if (!e || e->node == -1)
+        return;
+
+    int node = e->node;
+    nodeRemoveObject(node, obj);
+    mergeUpwards(node);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::update(const T& obj)
+{
+    ObjectEntry* e = entry(obj);
+    if (!e || e->node == -1)
+    {
+        if (VERBOSE)
+            std::cerr << "BasicQuadtree::update: trying to update an object [rect = " << Traits::rect(obj).str() << "] that is not present in the quadtree\n";
+        return;
+    }
+
+    // fast path: the object still fits in its node and cannot descend into a child
+    int node = e->node;
+    const RectF& nodeRect = _nodes[node].rect;
+    const RectF& objRect = Traits::rect(obj);
+    if ((node == 0 ? _rect : looseRect(nodeRect)).contains(objRect) &&
+        (isLeaf(node) || getObjectQuadrant(nodeRect, objRect) == -1))
+    {
+        addCategories(node, Traits::category(obj));   // in case the category has changed
+        return;
+    }
+
+    // remove without merging, so that re-adding the object in the same
+    // region does not undo and redo the same split at every move
+    nodeRemoveObject(node, obj);
+    add(obj);
+    mergeUpwards(node);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+template <typename Visitor>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::queryObjects(const RectF& queryRect, Visitor&& visitor, unsigned int categoryMask) const
+{
+    query(0, _rect, queryRect, visitor, categoryMask);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::queryIntersections(Pairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    pairs.clear();
+
+    // independent tasks, each filling its own buffer: nodes above PARALLEL_DEPTH
+    // (their own objects only) and whole subtrees rooted at PARALLEL_DEPTH
+    _intersectionTasks.clear();
+    collectIntersectionTasks(0, 0);
+    if (_taskPairs.size() < _intersectionTasks.size())
+        _taskPairs.resize(_intersectionTasks.size());
+
+    ThreadPool::instance()->parallelFor(int(_intersectionTasks.size()), [&](int i)
+        {
+            _taskPairs[i].clear();
+            if (_intersectionTasks[i].second)
+                queryIntersections(_intersectionTasks[i].first, _taskPairs[i], categoryMask, activeMask);
+            else
+                nodeIntersections(_intersectionTasks[i].first, _taskPairs[i], categoryMask, activeMask);
+        });
+
+    for (std::size_t i = 0; i < _intersectionTasks.size(); i++)
+        pairs.insert(pairs.end(), _taskPairs[i].begin(), _taskPairs[i].end());
+
+    // lower id object first in each pair, then pairs sorted by ids
+    for (auto& pair : pairs)
+        if (Traits::id(pair.second) < Traits::id(pair.first))
+            std::swap(pair.first, pair.second);
+    std::sort(pairs.begin(), pairs.end(), [](const std::pair<T, T>& a, const std::pair<T, T>& b)
+        {
+            return Traits::id(a.first) != Traits::id(b.first) ? Traits::id(a.first) < Traits::id(b.first) : Traits::id(a.second) < Traits::id(b.second);
+        });
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::raycast(const LineF& line, Hits& hits) const
+{
+    float tEnter, tExit;
+    if (RectF(_rect).intersectsLine(line.start, line.end, tEnter, tExit))
+        raycast(0, line, hits);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+template <typename Filter>
+const T* agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::raycastNearest(const LineF& line, float& tNear, Filter filter) const
+{
+    const T* nearest = nullptr;
+    float tBest = std::numeric_limits<float>::infinity();
+
+    float tEnter, tExit;
+    if (RectF(_rect).intersectsLine(line.start, line.end, tEnter, tExit))
+        raycastNearest(0, line, filter, nearest, tBest);
+
+    if (nearest)
+        tNear = tBest;
+    return nearest;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+template <typename Filter>
+std::vector<T> agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::queryNearest(const PointF& point, int k, Filter filter, float maxDistance) const
+{
+    // bounded max-heap of the k nearest candidates found so far (farthest on top, ties by id)
+    typedef std::pair<float, const T*> Candidate;
+    auto closer = [](const Candidate& a, const Candidate& b)
+        {
+            return a.first != b.first ? a.first < b.first : Traits::id(*a.second) < Traits::id(*b.second);
+        };
+    std::vector<Candidate> candidates;
+    std::size_t kk = std::max(k, 0);
+    candidates.reserve(kk);
+    auto bound = [&]() { return candidates.size() < kk ? maxDistance : candidates.front().first; };
+    auto addCandidate = [&](const T& obj)
+        {
+            float distance = Traits::rect(obj).distance(point);
+            if (distance > bound() || (candidates.size() == kk && distance == bound()) || !filter(obj))
+                return;
+            if (candidates.size() == kk)
+            {
+                std::pop_heap(candidates.begin(), candidates.end(), closer);
+                candidates.pop_back();
+            }
+            candidates.emplace_back(distance, &obj);
+            std::push_heap(candidates.begin(), candidates.end(), closer);
+        };
+
+    // best-first: nodes are visited by increasing distance from the point,
+    // until the nearest unvisited node is farther than the k-th candidate
+    if (kk)
+    {
+        typedef std::pair<float, int> NodeDistance;
+        std::priority_queue<NodeDistance, std::vector<NodeDistance>, std::greater<NodeDistance>> frontier;
+        frontier.emplace(_rect.distance(point), 0);
+        while (!frontier.empty())
+        {
+            NodeDistance top = frontier.top();
+            frontier.pop();
+            if (top.first > bound())
+                break;
+
+            int node = top.second;
+            for (const auto& obj : _nodes[node].objects)
+                addCandidate(obj);
+
+            if (!isLeaf(node))
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    int child = _nodes[node].children + i;
+                    float distance = looseRect(_nodes[child].rect).distance(point);
+                    if (distance <= bound())
+                        frontier.emplace(distance, child);
+                }
+            }
+        }
+    }
+
+    std::sort_heap(candidates.begin(), candidates.end(), closer);
+    std::vector<T> objects;
+    objects.reserve(candidates.size());
+    for (const auto& candidate : candidates)
+        objects.push_back(*candidate.second);
+    return objects;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+template <typename Filter>
+std::vector<T> agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::queryRadius(const PointF& point, float radius, Filter filter) const
+{
+    auto objects = std::vector<T>();
+    if (_rect.distance(point) <= radius)
+        queryRadius(0, point, radius, filter, objects);
+    return objects;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+agp::RectF agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::indexToQuadrant(const RectF& rect, int i) const
+{
+    PointF quadSize = rect.size / static_cast<float>(2);
+
+    switch (i)
+    {
+        case 0:
+            return RectF(rect.pos, rect.pos + quadSize, rect.yUp);
+        case 1:
+            return RectF(PointF(rect.pos.x + quadSize.x, rect.pos.y), PointF(rect.pos.x + quadSize.x, rect.pos.y) + quadSize, rect.yUp);
+        case 2:
+            return RectF(PointF(rect.pos.x, rect.pos.y + quadSize.y), PointF(rect.pos.x, rect.pos.y + quadSize.y) + quadSize, rect.yUp);
+        case 3:
+            return RectF(rect.pos + quadSize, rect.pos + 2 * quadSize, rect.yUp);
+        default:
+            throw "BasicQuadtree::indexToQuadrant: invalid child index";
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+agp::RectF agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::looseRect(const RectF& rect) const
+{
+    if (_looseness == 1)
+        return rect;
+    else
+        return rect.scaleOnCenter(_looseness);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+int agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::getObjectQuadrant(const RectF& quadRect, const RectF& objRect) const
+{
+    // loose: the only candidate is the quadrant containing the object center
+    if (_looseness > 1)
+    {
+        PointF quadCenter = quadRect.center();
+        PointF objCenter = objRect.center();
+        int i = (objCenter.x >= quadCenter.x ? 1 : 0) + (objCenter.y >= quadCenter.y ? 2 : 0);
+        return looseRect(indexToQuadrant(quadRect, i)).contains(objRect) ? i : -1;
+    }
+
+    for (int i = 0; i < 4; i++)
+        if (indexToQuadrant(quadRect, i).contains(objRect))
+            return i;
+
+    return -1;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::add(int node, std::size_t depth, const RectF& nodeRect, const T& obj)
+{
+    if (node < 0 || node >= int(_nodes.size()))
+        throw "BasicQuadtree::add: invalid node index";
+
+    if (!looseRect(nodeRect).contains(Traits::rect(obj)))
+        throw strprintf("BasicQuadtree::add: nodeRect (%s) does not fully contain object rect (%s)", nodeRect.str().c_str(), Traits::rect(obj).str().c_str());
+
+    if (isLeaf(node))
+    {
+        // insert in this node if necessary (max depth exceeded) or possible (max objects not exceeded)
+        if (depth >= MAX_DEPTH || _nodes[node].objects.size() < MAX_OBJECTS_PER_NODE)
+            nodeAddObject(node, obj);
+        // otherwise, split and try again
+        else
+        {
+            split(node, nodeRect);
+            add(node, depth, nodeRect, obj);
+        }
+    }
+    else
+    {
+        int i = getObjectQuadrant(nodeRect, Traits::rect(obj));
+        // add the value in a child if the value is entirely contained in it
+        if (i != -1)
+            add(_nodes[node].children + i, depth + 1, indexToQuadrant(nodeRect, i), obj);
+        // otherwise, add the value in the current node
+        else
+            nodeAddObject(node, obj);
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::split(int node, const RectF& nodeRect)
+{
+    if (node < 0 || node >= int(_nodes.size()))
+        throw "BasicQuadtree::split: invalid node index";
+
+    if (!isLeaf(node))
+        throw "BasicQuadtree::split: only leaves can be split";
+
+    // create children
+    int children = allocateChildren(node, nodeRect);
+    _nodes[node].children = children;
+
+    // assign objects to children or to current node
+    // (node objects are moved out first, since nodeAddObject updates slots)
+    auto oldObjects = std::move(_nodes[node].objects);
+    _nodes[node].objects.clear();
+    for (const auto& obj : oldObjects)
+    {
+        _objectToNode[Traits::denseId(obj)] = ObjectEntry();
+        auto i = getObjectQuadrant(nodeRect, Traits::rect(obj));
+        if (i != -1)
+            nodeAddObject(children + i, obj);
+        else
+            nodeAddObject(node, obj);
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::build(int node, int depth, const RectF& nodeRect, std::vector<BulkItem>& items, int begin, int end,
+    std::vector<int>& quadrants, std::vector<BulkItem>& buffer)
+{
+    // same shape as incremental adds: leaves hold up to MAX_OBJECTS_PER_NODE objects
+    // (any number at MAX_DEPTH), interior nodes hold the objects straddling their quadrants
+    int ownBegin = begin, ownEnd = end;
+    int counts[5] = { 0, 0, 0, 0, 0 };     // own objects, then quadrants 0-3
+    if (end - begin > MAX_OBJECTS_PER_NODE && depth < MAX_DEPTH)
+    {
+        int children = allocateChildren(node, nodeRect);
+        _nodes[node].children = children;
+
+        // stable counting sort by quadrant (same rule as getObjectQuadrant,
+        // with the quadrant rects computed once per node)
+        RectF quadRects[4];
+        for (int i = 0; i < 4; i++)
+            quadRects[i] = looseRect(indexToQuadrant(nodeRect, i));
+        PointF center = nodeRect.center();
+        for (int i = begin; i < end; i++)
+        {
+            const RectF& objRect = items[i].second;
+            int q = -1;
+            if (_looseness > 1)
+            {
+                PointF objCenter = objRect.center();
+                q = (objCenter.x >= center.x ? 1 : 0) + (objCenter.y >= center.y ? 2 : 0);
+                if (!quadRects[q].contains(objRect))
+                    q = -1;
+            }
+            else
+                for (int j = 0; j < 4 && q == -1; j++)
+                    if (quadRects[j].contains(objRect))
+                        q = j;
+            quadrants[i] = q + 1;
+            counts[q + 1]++;
+        }
+        int offsets[5] = { begin };
+        for (int q = 1; q < 5; q++)
+            offsets[q] = offsets[q - 1] + counts[q - 1];
+        ownEnd = offsets[1];
+        for (int i = begin; i < end; i++)
+            buffer[offsets[quadrants[i]]++] = items[i];
+        std::copy(buffer.begin() + begin, buffer.begin() + end, items.begin() + begin);
+
+        for (int i = 0, childBegin = ownEnd; i < 4; childBegin += counts[i + 1], i++)
+            build(children + i, depth + 1, indexToQuadrant(nodeRect, i), items, childBegin, childBegin + counts[i + 1], quadrants, buffer);
+    }
+
+    auto& nodeObjects = _nodes[node].objects;
+    nodeObjects.reserve(ownEnd - ownBegin);
+    unsigned int categories = 0;
+    for (int i = ownBegin; i < ownEnd; i++)
+    {
+        const T& obj = items[i].first;
+        _objectToNode[Traits::denseId(obj)] = { node, int(nodeObjects.size()) };
+        nodeObjects.push_back(obj);
+        categories |= Traits::category(obj);
+    }
+    if (!isLeaf(node))
+        for (int i = 0; i < 4; i++)
+            categories |= _nodes[_nodes[node].children + i].categories;
+    _nodes[node].categories = categories;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+int agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::allocateChildren(int parent, const RectF& parentRect)
+{
+    int first;
+    if (!_freeBlocks.empty())
+    {
+        first = _freeBlocks.back();
+        _freeBlocks.pop_back();
+    }
+    else
+    {
+        // might reallocate the pool: callers must not hold Node references across this call
+        first = int(_nodes.size());
+        _nodes.resize(_nodes.size() + 4);
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        _nodes[first + i].children = -1;
+        _nodes[first + i].parent = parent;
+        _nodes[first + i].rect = indexToQuadrant(parentRect, i);
+        _nodes[first + i].categories = 0;
+        _nodes[first + i].objects.clear();  // keeps capacity for reuse
+    }
+
+    return first;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::freeChildren(int node)
+{
+    _freeBlocks.push_back(_nodes[node].children);
+    _nodes[node].children = -1;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::nodeAddObject(int node, const T& obj)
+{
+    int denseId = Traits::denseId(obj);
+    if (denseId >= int(_objectToNode.size()))
+        _objectToNode.resize(std::max(std::size_t(denseId + 1), 2 * _objectToNode.size()));
+
+    ObjectEntry& e = _objectToNode[denseId];
+    if (e.node == node)
+    {
+        if (VERBOSE)
+            std::cerr << "BasicQuadtree::nodeAddObject: trying to add an object already present in the node\n";
+    }
+    else
+    {
+        e.node = node;
+        e.slot = int(_nodes[node].objects.size());
+        _nodes[node].objects.push_back(obj);
+        addCategories(node, Traits::category(obj));
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::nodeRemoveObject(int node, const T& obj)
+{
+    ObjectEntry* e = entry(obj);
+
+    if (!e || e->node != node)
+    {
+        if (VERBOSE)
+            std::cerr << "BasicQuadtree::nodeRemoveObject: trying to remove an object that is not present in the node\n";
+    }
+    else
+    {
+        // swap with the last element and pop back
+        // (the slot is saved first, since obj may refer to the last element)
+        auto& objects = _nodes[node].objects;
+        int slot = e->slot;
+        e->node = -1;
+        e->slot = -1;
+        if (slot != int(objects.size()) - 1)
+        {
+            objects[slot] = std::move(objects.back());
+            _objectToNode[Traits::denseId(objects[slot])].slot = slot;
+        }
+        objects.pop_back();
+
+        refreshCategories(node);
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::addCategories(int node, unsigned int categories)
+{
+    // ancestors always include the categories of their descendants:
+    // stop as soon as a node already has them
+    for (; node != -1 && (_nodes[node].categories & categories) != categories; node = _nodes[node].parent)
+        _nodes[node].categories |= categories;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::refreshCategories(int node)
+{
+    // recompute the exact masks bottom-up, until a mask does not change
+    for (; node != -1; node = _nodes[node].parent)
+    {
+        unsigned int categories = 0;
+        for (const auto& obj : _nodes[node].objects)
+            categories |= Traits::category(obj);
+        if (!isLeaf(node))
+            for (int i = 0; i < 4; i++)
+                categories |= _nodes[_nodes[node].children + i].categories;
+
+        if (categories == _nodes[node].categories)
+            break;
+        _nodes[node].categories = categories;
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+bool agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::tryMerge(int node)
+{
+    if (node < 0 || node >= int(_nodes.size()))
+        throw "BasicQuadtree::tryMerge: invalid node index";
+
+    if (isLeaf(node))
+        throw "BasicQuadtree::tryMerge: only interior nodes can be merged";
+
+    int children = _nodes[node].children;
+    auto objectsCount = _nodes[node].objects.size();
+    for (int i = 0; i < 4; i++)
+    {
+        if (!isLeaf(children + i))
+            return false;
+        objectsCount += _nodes[children + i].objects.size();
+    }
+    if (objectsCount <= MAX_OBJECTS_PER_NODE)
+    {
+        _nodes[node].objects.reserve(objectsCount);
+        // merge the objects of all the children
+        for (int i = 0; i < 4; i++)
+        {
+            for (const auto& obj : _nodes[children + i].objects)
+                nodeAddObject(node, obj);
+            _nodes[children + i].objects.clear();
+        }
+        // return the children to the pool
+        freeChildren(node);
+        return true;
+    }
+    else
+        return false;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::mergeUpwards(int node)
+{
+    // collapse the node itself if interior (e.g. it lost its straddling objects),
+    // then its ancestors as long as they become under-populated
+    int current = isLeaf(node) ? _nodes[node].parent : node;
+    while (current != -1 && tryMerge(current))
+        current = _nodes[current].parent;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+typename agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::ObjectEntry* agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::entry(const T& obj)
+{
+    int denseId = Traits::denseId(obj);
+    if (denseId < 0 || denseId >= int(_objectToNode.size()))
+        return nullptr;
+
+    return &_objectToNode[denseId];
+}
+
+// returns false if the visitor stopped the query
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+template <typename Visitor>
+bool agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::query(int node, const RectF& nodeRect, const RectF& queryRect, Visitor& visitor, unsigned int categoryMask) const
+{
+    if (node < 0 || node >= int(_nodes.size()))
+    {
+        std::cerr << "BasicQuadtree::query: invalid node index\n";
+        return true;
+    }
+
+    if (!queryRect.intersects(looseRect(nodeRect)))
+    {
+        if (VERBOSE)
+            std::cerr << strprintf("BasicQuadtree::query: queryRect (%s) does not intersect nodeRect (%s)\n", queryRect.str().c_str(), nodeRect.str().c_str());
+        return true;
+    }
+
+    // no object of the requested categories in this subtree
+    if (!(_nodes[node].categories & categoryMask))
+        return true;
+
+    for (const auto& value : _nodes[node].objects)
+    {
+        if ((Traits::category(value) & categoryMask) && queryRect.intersects(Traits::rect(value)) && !visitor(value))
+            return false;
+    }
+    if (!isLeaf(node))
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            RectF childRect = indexToQuadrant(nodeRect, i);
+            if (queryRect.intersects(looseRect(childRect)) && !query(_nodes[node].children + i, childRect, queryRect, visitor, categoryMask))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::raycast(int node, const LineF& line, Hits& hits) const
+{
+    float tHit;
+    for (const auto& obj : _nodes[node].objects)
+        if (Traits::intersectsLine(obj, line, tHit))
+            hits.emplace_back(obj, tHit);
+
+    if (!isLeaf(node))
+    {
+        float tEnter, tExit;
+        for (int i = 0; i < 4; i++)
+        {
+            int child = _nodes[node].children + i;
+            if (looseRect(_nodes[child].rect).intersectsLine(line.start, line.end, tEnter, tExit))
+                raycast(child, line, hits);
+        }
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+template <typename Filter>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::raycastNearest(int node, const LineF& line, Filter& filter, const T*& nearest, float& tNear) const
+{
+    float tHit;
+    for (const auto& obj : _nodes[node].objects)
+        if (Traits::intersectsLine(obj, line, tHit) && tHit < tNear && filter(obj))
+        {
+            nearest = &obj;
+            tNear = tHit;
+        }
+
+    if (isLeaf(node))
+        return;
+
+    // visit children crossed by the line front-to-back, skipping those
+    // entered after the nearest hit found so far
+    std::array<std::pair<float, int>, 4> crossed;
+    int crossedCount = 0;
+    float tEnter, tExit;
+    for (int i = 0; i < 4; i++)
+    {
+        int child = _nodes[node].children + i;
+        if (looseRect(_nodes[child].rect).intersectsLine(line.start, line.end, tEnter, tExit) && tEnter < tNear)
+            crossed[crossedCount++] = { tEnter, child };
+    }
+    std::sort(crossed.begin(), crossed.begin() + crossedCount);
+
+    for (int i = 0; i < crossedCount && crossed[i].first < tNear; i++)
+        raycastNearest(crossed[i].second, line, filter, nearest, tNear);
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+template <typename Filter>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::queryRadius(int node, const PointF& point, float radius, Filter& filter, std::vector<T>& objects) const
+{
+    for (const auto& obj : _nodes[node].objects)
+        if (Traits::rect(obj).distance(point) <= radius && filter(obj))
+            objects.push_back(obj);
+
+    if (!isLeaf(node))
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            int child = _nodes[node].children + i;
+            if (looseRect(_nodes[child].rect).distance(point) <= radius)
+                queryRadius(child, point, radius, filter, objects);
+        }
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::collectIntersectionTasks(int node, int depth) const
+{
+    if (depth == PARALLEL_DEPTH || isLeaf(node))
+        _intersectionTasks.emplace_back(node, true);
+    else
+    {
+        _intersectionTasks.emplace_back(node, false);
+        for (int i = 0; i < 4; i++)
+            collectIntersectionTasks(_nodes[node].children + i, depth + 1);
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::queryIntersections(int node, Pairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    if (!(_nodes[node].categories & categoryMask))
+        return;
+
+    nodeIntersections(node, pairs, categoryMask, activeMask);
+    if (!isLeaf(node))
+    {
+        for (int i = 0; i < 4; i++)
+            queryIntersections(_nodes[node].children + i, pairs, categoryMask, activeMask);
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::nodeIntersections(int node, Pairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    const auto& objects = _nodes[node].objects;
+    for (std::size_t i = 0; i < objects.size(); i++)
+    {
+        const T& obj = objects[i];
+        unsigned int category = Traits::category(obj);
+        if (!(category & categoryMask))
+            continue;
+
+        // an inactive object only pairs with active ones
+        unsigned int otherMask = (category & activeMask) ? ALL_CATEGORIES : activeMask;
+
+        // objects in this node (each pair found once) and in descendants
+        const RectF& objRect = Traits::rect(obj);
+        for (std::size_t j = 0; j < i; j++)
+        {
+            const T& other = objects[j];
+            if ((Traits::category(other) & categoryMask) && (Traits::category(other) & otherMask) && objRect.intersects(Traits::rect(other)))
+                pairs.emplace_back(obj, other);
+        }
+        if (!isLeaf(node))
+        {
+            for (int c = 0; c < 4; c++)
+                queryIntersectionsInDescendants(_nodes[node].children + c, obj, pairs, categoryMask, otherMask);
+        }
+    }
+
+    // loose: objects in different child subtrees intersect where the children loose bounds overlap
+    if (_looseness > 1 && !isLeaf(node))
+    {
+        int children = _nodes[node].children;
+        for (int a = 0; a < 4; a++)
+            for (int b = a + 1; b < 4; b++)
+                crossIntersections(children + a, children + b, pairs, categoryMask, activeMask);
+    }
+}
+
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::queryIntersectionsInDescendants(int node, const T& obj, Pairs& pairs, unsigned int categoryMask, unsigned int otherMask) const
+{
+    // no candidate in this subtree (nodes loose bounds enclose the objects of their subtree)
+    const RectF& objRect = Traits::rect(obj);
+    if (!(_nodes[node].categories & categoryMask) || !(_nodes[node].categories & otherMask) ||
+        !objRect.intersects(looseRect(_nodes[node].rect)))
+        return;
+
+    // test against the objects stored in this node
+    for (const auto& other : _nodes[node].objects)
+    {
+        if ((Traits::category(other) & categoryMask) && (Traits::category(other) & otherMask) && objRect.intersects(Traits::rect(other)))
+            pairs.emplace_back(obj, other);
+    }
+    // test against objects stored into descendants of this node
+    if (!isLeaf(node))
+    {
+        for (int i = 0; i < 4; i++)
+            queryIntersectionsInDescendants(_nodes[node].children + i, obj, pairs, categoryMask, otherMask);
+    }
+}
+
+// loose: pairs between the objects of two disjoint subtrees
+template <typename T, typename Traits, int MaxObjectsPerNode, int MaxDepth>
+void agp::BasicQuadtree<T, Traits, MaxObjectsPerNode, MaxDepth>::crossIntersections(int a, int b, Pairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    // no candidate pair (nodes loose bounds enclose the objects of their subtree)
+    if (!(_nodes[a].categories & categoryMask) || !(_nodes[b].categories & categoryMask) ||
+        !looseRect(_nodes[a].rect).intersects(looseRect(_nodes[b].rect)))
+        return;
+
+    // objects stored in a against the subtree b
+    for (const auto& obj : _nodes[a].objects)
+    {
+        unsigned int category = Traits::category(obj);
+        if (category & categoryMask)
+            queryIntersectionsInDescendants(b, obj, pairs, categoryMask, (category & activeMask) ? ALL_CATEGORIES : activeMask);
+    }
+    if (isLeaf(a))
+        return;
+
+    // objects stored in b against the descendants of a
+    for (const auto& obj : _nodes[b].objects)
+    {
+        unsigned int category = Traits::category(obj);
+        if (category & categoryMask)
+        {
+            for (int i = 0; i < 4; i++)
+                queryIntersectionsInDescendants(_nodes[a].children + i, obj, pairs, categoryMask, (category & activeMask) ? ALL_CATEGORIES : activeMask);
+        }
+    }
+
+    // descendants of a against descendants of b, level by level
+    if (!isLeaf(b))
+    {
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                crossIntersections(_nodes[a].children + i, _nodes[b].children + j, pairs, categoryMask, activeMask);
+    }
+}
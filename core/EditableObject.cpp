@@ -21,6 +21,7 @@ using namespace agp;
 EditableObject::EditableObject(Scene* scene, const RectF& r, const std::string& name, int category, std::vector<std::string>& categories)
 	: RenderableObject(scene, r, nullptr, 1), _categories(categories)
 {
+	addClassId<EditableObject>();
 	_category = category;
 	_name = name;
 	_selected = false;
@@ -36,6 +37,7 @@ EditableObject::EditableObject(Scene* scene, const RectF& r, const std::string&
 EditableObject::EditableObject(Scene* scene, const LineF& line, const std::string& name, int category, std::vector<std::string>& categories)
 	: RenderableObject(scene, line.boundingRect(scene->rect().yUp), nullptr, 1), _categories(categories)
 {
+	addClassId<EditableObject>();
 	_category = category;
 	_name = name;
 	_selected = false;
@@ -53,6 +55,7 @@ EditableObject::EditableObject(Scene* scene, const LineF& line, const std::strin
 EditableObject::EditableObject(Scene* scene, const nlohmann::json& j, std::vector<std::string>& categories)
 	: RenderableObject(scene, RectF(), nullptr, 1), _categories(categories)
 {
+	addClassId<EditableObject>();
 	_category = j["category"];
 	_name = j["name"];
 
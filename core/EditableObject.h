@@ -16,6 +16,7 @@ namespace agp
 {
 	class Scene;
 	class EditableObject;
+	template <> struct ClassId<EditableObject> { static constexpr int bit = 1; };
 }
 
 // EditableObject class.
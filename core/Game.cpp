@@ -19,6 +19,7 @@
 #include "Audio.h"
 #include "GPUShaderWindow.h"
 #include "CPUShaderWindow.h"
+#include "OffscreenWindow.h"
 
 using namespace agp;
 
@@ -38,6 +39,8 @@ Game::Game(
 		_window = new Window(windowTitle, int(_aspectRatio * windowSize.x), windowSize.y);
 	else if (rendering == Rendering::SDL_CPU_SHADERS)
 		_window = new CPUShaderWindow(windowTitle, int(_aspectRatio * windowSize.x), windowSize.y);
+	else if (rendering == Rendering::OFFSCREEN)
+		_window = new OffscreenWindow(windowTitle, int(_aspectRatio * windowSize.x), windowSize.y);
 	else if (rendering == Rendering::SDL_OPENGL_SHADERS)
 #ifdef WITH_SHADERS
 		_window = new GPUShaderWindow(windowTitle, int(_aspectRatio * windowSize.x), windowSize.y);
@@ -8,6 +8,7 @@
 // ----------------------------------------------------------------
 
 #include "GameScene.h"
+#include <atomic>
 #include "RenderableObject.h"
 #include "View.h"
 #include "Game.h"
@@ -16,11 +17,17 @@
 #include "EditorScene.h"
 #include "EditorUI.h"
 #include "timeUtils.h"
+#include "Quadtree.h"
+#include "UniformGrid.h"
+#include "AABBTree.h"
+#include "StaticIndex.h"
+#include "LinearQuadtree.h"
+#include "SpatialSnapshot.h"
 
 using namespace agp;
 
 GameScene::GameScene(const RectF& rect, const Point& pixelUnitSize, float dt)
-	: Scene(rect, pixelUnitSize), _quadtree(rect)
+	: Scene(rect, pixelUnitSize)
 {
 	_dt = dt;
 	_timeToSimulateAccum = 0;
@@ -32,8 +39,20 @@ GameScene::GameScene(const RectF& rect, const Point& pixelUnitSize, float dt)
 	_cameraFollowsPlayer = true;
 	_displayGameSceneOnly = false;
 	_autoKillWhenOutsideScene = true;
-	_useQuadtree = false;
+	_spatialIndex = new Quadtree(rect);
+	_useSpatialIndex = false;
+	_deferSpatialUpdates = false;
+	_bulkLoading = true;		// level objects are created right after the scene
+	_staticIndex = new StaticIndex(rect);
+	_staticCategories = 0;
+	_activation = false;
+	_lodDistances[0] = 16;
+	_lodDistances[1] = 48;
+	_step = 0;
+	_snapshots = false;
+	_snapshotVersion = 0;
 	_jsonPath = std::string(SDL_GetBasePath()) + "/EditorScene.json";
+	_objectTimers.setTick(dt);
 
 	_view = new View(this, _rect);
 	float ar = Game::instance()->aspectRatio();
@@ -41,20 +60,261 @@ GameScene::GameScene(const RectF& rect, const Point& pixelUnitSize, float dt)
 		_view->setFixedAspectRatio(ar);
 }
 
+GameScene::~GameScene()
+{
+	delete _spatialIndex;
+	delete _staticIndex;
+}
+
+void GameScene::setSpatialIndex(SpatialIndex* index)
+{
+	if (!index)
+		throw "GameScene::setSpatialIndex: null spatial index";
+
+	if (index == _spatialIndex)
+		return;
+
+	delete _spatialIndex;
+	_spatialIndex = index;
+
+	// move alive objects (including those not yet refreshed) into the new index
+	_bulkObjects.clear();
+	for (auto& obj : _objects)
+		if (!obj->killed() && !_staticIndex->contains(obj))
+			_bulkObjects.push_back(obj);
+	for (auto& obj : _newObjects)
+		if (!obj->killed() && !_staticIndex->contains(obj))
+			_bulkObjects.push_back(obj);
+	_spatialIndex->bulkLoad(_bulkObjects);
+	_bulkObjects.clear();
+}
+
+void GameScene::setStaticCategories(unsigned int categories)
+{
+	_staticCategories = categories;
+
+	// sleeping static objects are reclassified now, updated ones after their next update
+	for (auto& obj : _objects)
+		if (obj->_updateMode == Object::UPDATE_NONE || obj->_updateMode == Object::UPDATE_SPRITE)
+			setUpdateMode(obj, defaultUpdateMode(obj));
+
+	// objects whose category now matches (or no more) change index
+	if (_useSpatialIndex)
+	{
+		for (auto& obj : _objects)
+			if (!obj->killed())
+				updateSpatialIndex(obj);
+		for (auto& obj : _newObjects)
+			if (!obj->killed())
+				updateSpatialIndex(obj);
+	}
+}
+
+void GameScene::setUseQuadtree(bool on, float looseness)
+{
+	_useSpatialIndex = on;
+	if (!on)
+		return;
+
+	Quadtree* quadtree = dynamic_cast<Quadtree*>(_spatialIndex);
+	if (quadtree)
+		quadtree->setLooseness(looseness);
+	else
+		setSpatialIndex(new Quadtree(_rect, looseness));
+}
+
+void GameScene::setUseUniformGrid(bool on, const PointF& cellSize)
+{
+	_useSpatialIndex = on;
+	if (!on)
+		return;
+
+	PointF size = cellSize;
+	if (size.x <= 0 || size.y <= 0)
+		size = UniformGrid::cellSizeFromPixelUnitSize(_pixelUnitSize);
+
+	UniformGrid* grid = dynamic_cast<UniformGrid*>(_spatialIndex);
+	if (!grid || grid->cellSize() != size)
+		setSpatialIndex(new UniformGrid(_rect, size));
+}
+
+void GameScene::setUseAABBTree(bool on, float margin)
+{
+	_useSpatialIndex = on;
+	if (!on)
+		return;
+
+	AABBTree* tree = dynamic_cast<AABBTree*>(_spatialIndex);
+	if (!tree || tree->margin() != margin)
+		setSpatialIndex(new AABBTree(_rect, margin));
+}
+
+void GameScene::setUseLinearQuadtree(bool on)
+{
+	_useSpatialIndex = on;
+	if (!on)
+		return;
+
+	if (!dynamic_cast<LinearQuadtree*>(_spatialIndex))
+		setSpatialIndex(new LinearQuadtree(_rect));
+}
+
+void GameScene::rebuildSpatialIndex()
+{
+	flushMovedObjects();
+	if (_useSpatialIndex)
+		_spatialIndex->rebuild();
+
+	if (_snapshots)
+		publishSnapshot();
+}
+
+void GameScene::setSnapshots(bool on)
+{
+	_snapshots = on;
+	if (on)
+		publishSnapshot();
+	else
+	{
+		// readers still holding a snapshot keep it alive
+		std::atomic_store(&_snapshot, std::shared_ptr<SpatialSnapshot>());
+		_backSnapshot.reset();
+	}
+}
+
+void GameScene::publishSnapshot()
+{
+	// alive objects (including those not yet refreshed)
+	_snapshotObjects.clear();
+	for (auto& obj : _objects)
+		if (!obj->killed())
+			_snapshotObjects.push_back(obj);
+	for (auto& obj : _newObjects)
+		if (!obj->killed())
+			_snapshotObjects.push_back(obj);
+
+	// double buffering: the previous snapshot is rebuilt in place if no reader holds it,
+	// otherwise it is left to its readers and a new one is allocated
+	// (use_count is a relaxed load: the fence orders the rebuild after the last reader released it)
+	if (!_backSnapshot || _backSnapshot.use_count() > 1)
+		_backSnapshot = std::make_shared<SpatialSnapshot>(_rect);
+	else
+		std::atomic_thread_fence(std::memory_order_acquire);
+	_backSnapshot->build(_snapshotObjects, ++_snapshotVersion);
+	_backSnapshot = std::atomic_exchange(&_snapshot, _backSnapshot);
+}
+
+void GameScene::setDeferSpatialUpdates(bool on)
+{
+	if (!on)
+		flushMovedObjects();
+
+	_deferSpatialUpdates = on;
+}
+
+void GameScene::setBulkLoading(bool on)
+{
+	if (!on)
+		flushMovedObjects();
+
+	_bulkLoading = on;
+}
+
+void GameScene::flushMovedObjects()
+{
+	// new objects collected so far (i.e. at level load): one-pass build
+	if (_bulkLoading)
+	{
+		// objects are routed by their current category (it may have changed meanwhile), so that
+		// only the dynamic remainder is bulk loaded: objects killed or already in the static
+		// index are skipped, objects now static go to the static index
+		_bulkLoading = false;
+		size_t dynamicCount = 0;
+		for (auto obj : _bulkObjects)
+		{
+			if (obj->killed() || _staticIndex->contains(obj))
+				continue;
+			if (obj->category() & _staticCategories)
+				_staticIndex->add(obj);
+			else
+				_bulkObjects[dynamicCount++] = obj;
+		}
+		_bulkObjects.resize(dynamicCount);
+
+		// pending reclassifications from the static index are bulk loaded too
+		for (auto obj : _movedObjects)
+			if (!obj->killed() && !(obj->category() & _staticCategories) && _staticIndex->contains(obj))
+			{
+				_staticIndex->remove(obj);
+				_bulkObjects.push_back(obj);
+			}
+
+		_spatialIndex->bulkLoad(_bulkObjects);
+		_bulkObjects.clear();
+	}
+
+	if (!_movedObjects.empty())
+	{
+		static Profiler spatialIndexFlushProfiler("spatial index flush", 5000);
+		spatialIndexFlushProfiler.begin();
+
+		// objects are swapped out first, since updates may kill objects
+		Objects movedObjects;
+		movedObjects.swap(_movedObjects);
+		for (auto obj : movedObjects)
+		{
+			_movedFlags[obj->denseId()] = false;
+			if (!obj->killed())
+				updateSpatialIndex(obj);
+		}
+		movedObjects.clear();
+		_movedObjects.swap(movedObjects);	// keep capacity
+
+		spatialIndexFlushProfiler.end();
+	}
+
+	// static objects added or changed (i.e. at level load): one-pass rebuild
+	if (_staticIndex->dirty())
+		_staticIndex->build();
+}
+
 void GameScene::newObject(Object* obj)
 {
 	Scene::newObject(obj);
 
-	if(_useQuadtree)
-		_quadtree.add(obj);
+	if (_useSpatialIndex)
+	{
+		if (obj->category() & _staticCategories)
+			_staticIndex->add(obj);
+		else if (_bulkLoading)
+			_bulkObjects.push_back(obj);
+		else
+			_spatialIndex->add(obj);
+	}
 }
 
 void GameScene::killObject(Object* obj)
 {
+	if (obj->killed())
+		return;
+
 	Scene::killObject(obj);
 
-	if (_useQuadtree)
-		_quadtree.remove(obj);
+	if (_useSpatialIndex)
+	{
+		if (_staticIndex->contains(obj))
+			_staticIndex->remove(obj);
+		else
+			_spatialIndex->remove(obj);
+	}
+}
+
+void GameScene::refreshObjects()
+{
+	// flush before dead objects are deallocated
+	flushMovedObjects();
+
+	Scene::refreshObjects();
 }
 
 void GameScene::objectMoved(Object* obj)
@@ -64,6 +324,297 @@ void GameScene::objectMoved(Object* obj)
 	if (obj->killed())
 		return;
 
+	// e.g. category no more static
+	if (obj->_updateMode != Object::UPDATE_FULL)
+		wakeObject(obj);
+
+	// deferred mode: just mark the object, the spatial index is updated at flush
+	if (_deferSpatialUpdates)
+	{
+		if (obj->denseId() >= int(_movedFlags.size()))
+			_movedFlags.resize(std::max(std::size_t(obj->denseId() + 1), 2 * _movedFlags.size()), false);
+		if (!_movedFlags[obj->denseId()])
+		{
+			_movedFlags[obj->denseId()] = true;
+			_movedObjects.push_back(obj);
+		}
+		return;
+	}
+
+	static Profiler spatialIndexUpdateProfiler("spatial index update", 5000);
+	spatialIndexUpdateProfiler.begin();
+	updateSpatialIndex(obj);
+	spatialIndexUpdateProfiler.end();
+}
+
+void GameScene::objectAdded(Object* obj)
+{
+	Scene::objectAdded(obj);
+
+	setUpdateMode(obj, defaultUpdateMode(obj));
+}
+
+void GameScene::objectRemoved(Object* obj)
+{
+	Scene::objectRemoved(obj);
+
+	setUpdateMode(obj, Object::UPDATE_NONE);
+
+	// moved after the flush (e.g. by a destructor during the refresh): no longer pending
+	if (obj->denseId() < int(_movedFlags.size()) && _movedFlags[obj->denseId()])
+	{
+		_movedFlags[obj->denseId()] = false;
+		_movedObjects.erase(std::find(_movedObjects.begin(), _movedObjects.end(), obj));
+	}
+}
+
+void GameScene::wakeObject(Object* obj)
+{
+	Scene::wakeObject(obj);
+
+	// not yet added objects are classified at refresh, removed ones (e.g. being
+	// deallocated) are ignored, objects out of the activation region are woken by the region only
+	if (obj->_sceneIndex < 0)
+		return;
+	if (obj->_updateMode != Object::UPDATE_FROZEN && obj->_updateMode != Object::UPDATE_COARSE)
+		setUpdateMode(obj, Object::UPDATE_FULL);
+}
+
+void GameScene::setActivation(bool on, const PointF& margin, const PointF& hysteresis)
+{
+	if (margin.x < 0 || margin.y < 0 || hysteresis.x < 0 || hysteresis.y < 0)
+		throw "GameScene::setActivation: margin and hysteresis must be >= 0";
+
+	_activation = on;
+	_activationMargin = margin;
+	_activationHysteresis = hysteresis;
+
+	// everything wakes up (sleeps again at the next update if out of the new region)
+	while (!_frozenObjects.empty())
+		wakeSleepingObject(_frozenObjects.back());
+	for (auto& list : _lodObjects)
+		while (!list.empty())
+			wakeSleepingObject(list.back());
+}
+
+void GameScene::setLodDistances(float half, float quarter)
+{
+	if (half < 0 || quarter < half)
+		throw "GameScene::setLodDistances: distances must be >= 0 and increasing";
+
+	_lodDistances[0] = half;
+	_lodDistances[1] = quarter;
+}
+
+int GameScene::lodCount(int level) const
+{
+	if (level < 0 || level > LOD_LEVELS)
+		throw "GameScene::lodCount: level out of range";
+
+	if (level == 0)
+		return int(_updatedObjects.size());
+
+	int count = 0;
+	int period = 1 << level;
+	for (int phase = 0; phase < period; phase++)
+		count += int(_lodObjects[period - 2 + phase].size());
+	return count;
+}
+
+int GameScene::lodList(Object* obj, const RectF& deactivationRect)
+{
+	// distance from the region (max over axes)
+	const RectF& r = obj->rect();
+	float dx = std::max(deactivationRect.pos.x - (r.pos.x + r.size.x), r.pos.x - (deactivationRect.pos.x + deactivationRect.size.x));
+	float dy = std::max(deactivationRect.pos.y - (r.pos.y + r.size.y), r.pos.y - (deactivationRect.pos.y + deactivationRect.size.y));
+	float distance = std::max(dx, dy);
+
+	int level = 1;
+	while (level < LOD_LEVELS && distance > _lodDistances[level - 1])
+		level++;
+	int period = 1 << level;
+
+	// objects already in this rate bucket keep their phase
+	if (obj->_updateMode == Object::UPDATE_COARSE && obj->_lodList >= period - 2 && obj->_lodList < 2 * period - 2)
+		return obj->_lodList;
+
+	int best = period - 2;
+	for (int list = best + 1; list < 2 * period - 2; list++)
+		if (_lodObjects[list].size() < _lodObjects[best].size())
+			best = list;
+	return best;
+}
+
+RectF GameScene::activationRect(bool withHysteresis) const
+{
+	PointF margin = withHysteresis ? _activationMargin + _activationHysteresis : _activationMargin;
+	const RectF& viewRect = _view->rect();
+	return RectF(viewRect.pos.x - margin.x, viewRect.pos.y - margin.y, viewRect.size.x + 2 * margin.x, viewRect.size.y + 2 * margin.y);
+}
+
+void GameScene::wakeActivationRegion()
+{
+	if (_frozenObjects.empty() && lodCount(1) + lodCount(2) + lodCount(3) == 0)
+		return;
+
+	// static objects never sleep out of the region
+	// (woken after the query, since catching up may move objects)
+	objects(activationRect(), [this](Object* obj)
+		{
+			if (obj->_updateMode == Object::UPDATE_FROZEN || obj->_updateMode == Object::UPDATE_COARSE)
+				_wokenObjects.push_back(obj);
+			return true;
+		}, ~_staticCategories);
+	for (auto& obj : _wokenObjects)
+		wakeSleepingObject(obj);
+	_wokenObjects.clear();
+}
+
+void GameScene::wakeSleepingObject(Object* obj)
+{
+	// coarse-ticked objects integrate the steps skipped since their last update
+	// (up to the previous one, the current step is a full update)
+	if (obj->_updateMode == Object::UPDATE_COARSE && _step > obj->_lodStep + 1 && !obj->freezed())
+	{
+		unsigned int skipped = _step - 1 - obj->_lodStep;
+		obj->_lodStep = _step - 1;
+		obj->update(_dt * skipped);
+	}
+
+	if (obj->_updateMode == Object::UPDATE_FROZEN || obj->_updateMode == Object::UPDATE_COARSE)
+		setUpdateMode(obj, Object::UPDATE_FULL);
+}
+
+Object::UpdateMode GameScene::defaultUpdateMode(Object* obj)
+{
+	if (!(obj->category() & _staticCategories) || obj->killed())
+		return Object::UPDATE_FULL;
+
+	RenderableObject* renderable = obj->to<RenderableObject*>();
+	if (renderable && renderable->sprite() && renderable->sprite()->animated())
+		return Object::UPDATE_SPRITE;
+
+	return Object::UPDATE_NONE;
+}
+
+Objects* GameScene::updateList(Object::UpdateMode mode, int lodList)
+{
+	switch (mode)
+	{
+		case Object::UPDATE_FULL: return &_updatedObjects;
+		case Object::UPDATE_SPRITE: return &_animatedObjects;
+		case Object::UPDATE_FROZEN: return &_frozenObjects;
+		case Object::UPDATE_COARSE: return &_lodObjects[lodList];
+		default: return nullptr;
+	}
+}
+
+void GameScene::setUpdateMode(Object* obj, Object::UpdateMode mode, int lodList)
+{
+	if (obj->_updateMode == mode && obj->_lodList == lodList)
+		return;
+
+	// O(1) removal: the last object takes the freed slot
+	Objects* list = updateList(obj->updateMode(), obj->_lodList);
+	if (list)
+	{
+		Object* last = list->back();
+		(*list)[obj->_updateSlot] = last;
+		last->_updateSlot = obj->_updateSlot;
+		list->pop_back();
+		obj->_updateSlot = -1;
+	}
+
+	list = updateList(mode, lodList);
+	if (list)
+	{
+		obj->_updateSlot = int(list->size());
+		list->push_back(obj);
+	}
+	bool wasFrozen = obj->_updateMode == Object::UPDATE_FROZEN;
+	obj->_updateMode = mode;
+	obj->_lodList = lodList;
+
+	// timers stop counting down while the object sleeps
+	if (wasFrozen != (mode == Object::UPDATE_FROZEN))
+		_objectTimers.setPaused(obj->_timers, !TimerWheel::running(obj));
+}
+
+void GameScene::updateObjects(float dt)
+{
+	RectF deactivationRect;
+	if (_activation)
+	{
+		wakeActivationRegion();
+		deactivationRect = activationRect(true);
+	}
+
+	// index-based: objects may be woken up (appended) meanwhile
+	for (size_t i = 0; i < _updatedObjects.size(); )
+	{
+		Object* obj = _updatedObjects[i];
+		if (!obj->freezed())
+			obj->update(dt);		// physics, collision, logic, animation
+
+		// static objects and objects out of the activation region go to sleep
+		// once done (the last object takes this slot)
+		Object::UpdateMode mode = Object::UPDATE_FULL;
+		if (obj->category() & _staticCategories)
+			mode = defaultUpdateMode(obj);
+		else if (_activation && obj->_activationPolicy != Object::ALWAYS_ACTIVE && obj != _player &&
+			!obj->killed() && !obj->rect().intersects(deactivationRect))
+			mode = obj->_activationPolicy == Object::FREEZE ? Object::UPDATE_FROZEN : Object::UPDATE_COARSE;
+		if (obj->_updateMode == Object::UPDATE_FULL && mode != Object::UPDATE_FULL)
+		{
+			obj->_lodStep = _step;
+			setUpdateMode(obj, mode, mode == Object::UPDATE_COARSE ? lodList(obj, deactivationRect) : -1);
+		}
+		else
+			i++;
+	}
+
+	// coarse-ticked objects: the lists of the current phase of each rate, with the dt accumulated
+	// since their last update; they may change rate after each update
+	// (backwards: objects leaving a list are replaced by the last one, already updated)
+	for (int level = 1; level <= LOD_LEVELS; level++)
+	{
+		int period = 1 << level;
+		Objects& list = _lodObjects[period - 2 + _step % period];
+		for (size_t i = list.size(); i-- > 0; )
+		{
+			if (i >= list.size())
+				continue;
+
+			// objects that just changed rate may be met again in this step
+			Object* obj = list[i];
+			if (obj->_lodStep == _step)
+				continue;
+
+			float lodDt = dt * (_step - obj->_lodStep);
+			obj->_lodStep = _step;
+			if (!obj->freezed())
+				obj->update(lodDt);
+
+			if (obj->_updateMode == Object::UPDATE_COARSE)
+				setUpdateMode(obj, Object::UPDATE_COARSE, lodList(obj, deactivationRect));
+		}
+	}
+	_step++;
+
+	// object timers: one tick per step, only due timers are visited
+	_objectTimers.advance(dt);
+
+	// animated static objects: sprite only
+	for (auto& obj : _animatedObjects)
+	{
+		RenderableObject* renderable = static_cast<RenderableObject*>(obj);
+		if (!renderable->freezed() && renderable->sprite())
+			renderable->sprite()->update(dt);
+	}
+}
+
+void GameScene::updateSpatialIndex(Object* obj)
+{
 	if (!_rect.contains(obj->rect())) 
 	{
 		if(_autoKillWhenOutsideScene && obj != _player)
@@ -71,45 +622,189 @@ void GameScene::objectMoved(Object* obj)
 		return;
 	}
 
-	static Profiler quadtreeUpdateProfiler("quadtree update", 5000);
-	quadtreeUpdateProfiler.begin();
-	if (_useQuadtree)
-		_quadtree.update(obj);
-	quadtreeUpdateProfiler.end();
+	if (!_useSpatialIndex)
+		return;
+
+	// objects whose category changed may move between the dynamic and the static index
+	bool isStatic = obj->category() & _staticCategories;
+	if (isStatic != _staticIndex->contains(obj))
+	{
+		if (isStatic)
+		{
+			_spatialIndex->remove(obj);
+			_staticIndex->add(obj);
+		}
+		else
+		{
+			_staticIndex->remove(obj);
+			_spatialIndex->add(obj);
+		}
+	}
+	else if (isStatic)
+		_staticIndex->update(obj);
+	else
+		_spatialIndex->update(obj);
 }
 
-Objects GameScene::objects()
+void GameScene::objects(const RectF& cullingRect, const ObjectVisitor& visitor, unsigned int categoryMask)
 {
-	return Scene::objects();
+	flushMovedObjects();
+
+	if (!_useSpatialIndex)
+	{
+		Scene::objects(cullingRect, visitor, categoryMask);
+		return;
+	}
+
+	// dynamic objects first, then static ones unless the visitor stopped
+	bool stopped = false;
+	_spatialIndex->queryObjects(cullingRect, [&](Object* obj)
+		{
+			stopped = !visitor(obj);
+			return !stopped;
+		}, categoryMask);
+	if (!stopped)
+		_staticIndex->queryObjects(cullingRect, visitor, categoryMask);
 }
 
-Objects GameScene::objects(const RectF& cullingRect)
+void GameScene::objects(const PointF& containPoint, const ObjectVisitor& visitor)
 {
-	if (_useQuadtree)
-		return _quadtree.queryObjects(cullingRect);
-	else
-		return Scene::objects(cullingRect);
+	flushMovedObjects();
+
+	if (!_useSpatialIndex)
+	{
+		Scene::objects(containPoint, visitor);
+		return;
+	}
+
+	GameScene::objects(RotatedRectF(containPoint, { 1,1 }, 0, _rect.yUp).toRect(), [&](Object* obj)
+		{
+			return !obj->contains(containPoint) || visitor(obj);
+		});
 }
 
-Objects GameScene::objects(const PointF& containPoint)
+void GameScene::raycast(const LineF& line, RaycastHits& hits)
 {
-	std::vector<Object*> candidates = _quadtree.queryObjects(RotatedRectF(containPoint, { 1,1 }, 0, _rect.yUp).toRect());
-	std::vector<Object*> results;
-	for (auto obj : candidates)
-		if (obj->contains(containPoint))
-			results.push_back(obj);
+	flushMovedObjects();
+
+	if (!_useSpatialIndex)
+	{
+		Scene::raycast(line, hits);
+		return;
+	}
 
-	return results;
+	hits.clear();
+	_spatialIndex->raycast(line, hits);
+	_staticIndex->raycast(line, hits);
+	std::sort(hits.begin(), hits.end(),
+		[](const std::pair<Object*, float>& a, const std::pair<Object*, float>& b) {
+			return a.second < b.second;
+		});
+}
+
+Object* GameScene::raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter)
+{
+	flushMovedObjects();
+
+	if (!_useSpatialIndex)
+		return Scene::raycastNearest(line, tNear, filter);
+
+	float tStatic;
+	Object* nearest = _spatialIndex->raycastNearest(line, tNear, filter);
+	Object* nearestStatic = _staticIndex->raycastNearest(line, tStatic, filter);
+	if (nearestStatic && (!nearest || tStatic < tNear))
+	{
+		tNear = tStatic;
+		return nearestStatic;
+	}
+	return nearest;
+}
+
+Objects GameScene::nearestObjects(const PointF& point, int k, const ObjectFilter& filter, float maxDistance)
+{
+	flushMovedObjects();
+
+	if (!_useSpatialIndex)
+		return Scene::nearestObjects(point, k, filter, maxDistance);
+
+	// merge the k nearest of each index (both sorted by distance)
+	Objects nearestDynamic = _spatialIndex->queryNearest(point, k, filter, maxDistance);
+	Objects nearestStatic = _staticIndex->queryNearest(point, k, filter, maxDistance);
+	if (nearestStatic.empty())
+		return nearestDynamic;
+
+	Objects nearest(nearestDynamic.size() + nearestStatic.size());
+	std::merge(nearestDynamic.begin(), nearestDynamic.end(), nearestStatic.begin(), nearestStatic.end(), nearest.begin(),
+		[&point](Object* a, Object* b) { return a->rect().distance(point) < b->rect().distance(point); });
+	if (int(nearest.size()) > k)
+		nearest.resize(k);
+	return nearest;
+}
+
+Objects GameScene::objectsWithin(const PointF& point, float radius, const ObjectFilter& filter)
+{
+	flushMovedObjects();
+
+	if (!_useSpatialIndex)
+		return Scene::objectsWithin(point, radius, filter);
+
+	Objects objectsSelected = _spatialIndex->queryRadius(point, radius, filter);
+	Objects objectsStatic = _staticIndex->queryRadius(point, radius, filter);
+	objectsSelected.insert(objectsSelected.end(), objectsStatic.begin(), objectsStatic.end());
+	return objectsSelected;
 }
 
 bool GameScene::isEmpty(const RectF& rect)
 {
-	if (_useQuadtree)
-		return _quadtree.queryObjects(rect).empty();
+	flushMovedObjects();
+
+	if (_useSpatialIndex)
+	{
+		bool empty = true;
+		GameScene::objects(rect, [&empty](Object*) { empty = false; return false; });
+		return empty;
+	}
 	else
 		return Scene::isEmpty(rect);
 }
 
+void GameScene::intersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask)
+{
+	flushMovedObjects();
+
+	if (!_useSpatialIndex)
+	{
+		Scene::intersections(pairs, categoryMask, activeMask);
+		return;
+	}
+
+	// dynamic vs. dynamic, static vs. static
+	_spatialIndex->queryIntersections(pairs, categoryMask, activeMask);
+	_staticIndex->queryIntersections(_staticPairs, categoryMask, activeMask);
+	pairs.insert(pairs.end(), _staticPairs.begin(), _staticPairs.end());
+
+	// dynamic vs. static: each dynamic object queries the static index
+	auto queryStatic = [&](Object* obj)
+	{
+		if (obj->killed() || !(obj->category() & categoryMask) || _staticIndex->contains(obj) || !_rect.contains(obj->rect()))
+			return;
+
+		unsigned int otherMask = (obj->category() & activeMask) ? ALL_CATEGORIES : activeMask;
+		_staticIndex->queryObjects(obj->rect(), [&](Object* other)
+			{
+				if (other->category() & otherMask)
+					pairs.emplace_back(obj, other);
+				return true;
+			}, categoryMask);
+	};
+	for (auto& obj : _objects)
+		queryStatic(obj);
+	for (auto& obj : _newObjects)
+		queryStatic(obj);
+
+	SpatialIndex::sortPairs(pairs);
+}
+
 void GameScene::render()
 {
 	if (_active)
@@ -162,10 +857,8 @@ void GameScene::updateWorld(float timeToSimulate)
 	_timeToSimulateAccum += timeToSimulate;
 	while (_timeToSimulateAccum >= _dt)
 	{
-		for (auto& obj : _objects)
-			if (!obj->freezed())
-				obj->update(_dt);		// physics, collision, logic, animation
-
+		updateObjects(_dt);
+		rebuildSpatialIndex();
 		_timeToSimulateAccum -= _dt;
 	}
 
@@ -8,20 +8,36 @@
 // ----------------------------------------------------------------
 
 #pragma once
+#include <memory>
 #include "Scene.h"
 #include "graphicsUtils.h"
-#include "Quadtree.h"
+#include "SpatialIndex.h"
+#include "Object.h"
 
 namespace agp
 {
 	class GameScene;
 	class OverlayScene;
 	class RenderableObject;
+	class StaticIndex;
+	class SpatialSnapshot;
 }
 
 // GameScene (or World) class
 // - specialized update(dt) to semifixed timestep
-// - provides more efficient access to game objects (quadtree)
+// - provides more efficient access to game objects (spatial index: quadtree, uniform grid, AABB tree)
+// - objects matching the static categories are stored in a separate read-only index,
+//   built once after level load, and queried alongside the dynamic one
+// - objects matching the static categories are not updated each step (only their
+//   animated sprites are), unless killed; their timers run anyway (see TimerWheel)
+// - optional activation region around the view: objects out of it sleep according to
+//   their activation policy (freeze or coarse tick), and are woken by a spatial query
+//   as soon as they enter it (objects sleep only once out of a larger region: hysteresis)
+// - coarse-ticked objects are updated at 1/2, 1/4 or 1/8 rate depending on their distance
+//   from the region, with the accumulated dt; each rate bucket is split into per-phase
+//   lists (filled evenly) so that the load spreads evenly across steps
+// - optionally publishes an immutable snapshot of the objects at the end of each step,
+//   for queries run on other threads while the world keeps changing
 // - can/should be subclassed for the specific game to implement 
 // - stores the main player and implements basic controls
 class agp::GameScene : public Scene
@@ -53,8 +69,43 @@ class agp::GameScene : public Scene
 		float _cameraZoomVel;		// camera zoom velocity (in [0,1] relative scale units)
 
 		// space partitioning
-		Quadtree _quadtree;
-		bool _useQuadtree;
+		SpatialIndex* _spatialIndex;	// owned, Quadtree by default
+		bool _useSpatialIndex;
+		bool _deferSpatialUpdates;		// if true, moved objects are only marked and flushed
+										// into the spatial index once per step or before queries
+		Objects _movedObjects;			// objects moved since the last flush
+		std::vector<bool> _movedFlags;	// indexed by dense object id, avoids duplicates in _movedObjects
+		bool _bulkLoading;				// if true, new objects are only collected and bulk loaded
+										// into the spatial index at the next flush (e.g. level load)
+		Objects _bulkObjects;			// new objects waiting for the bulk load
+		StaticIndex* _staticIndex;		// owned, objects that never move (e.g. level geometry)
+		unsigned int _staticCategories;	// objects stored in the static index (0 = none)
+		ObjectPairs _staticPairs;		// reused across broadphase queries
+
+		// per-step updates (see Object::UpdateMode)
+		Objects _updatedObjects;		// UPDATE_FULL objects, in scene order until the first reclassification
+		Objects _animatedObjects;		// UPDATE_SPRITE objects
+
+		// activation region
+		bool _activation;				// if true, objects out of the activation region sleep
+		PointF _activationMargin;		// activation region = view rect + margin (on each side)
+		PointF _activationHysteresis;	// objects sleep once out of activation region + hysteresis
+		Objects _frozenObjects;			// UPDATE_FROZEN objects
+
+		// reduced-rate (level of detail) updates of coarse-ticked objects
+		static constexpr int LOD_LEVELS = 3;				// 1/2, 1/4, 1/8 rates
+		static constexpr int LOD_LISTS = 2 + 4 + 8;			// one list per (rate, phase)
+		Objects _lodObjects[LOD_LISTS];	// UPDATE_COARSE objects, rate 1/p and phase f at index p - 2 + f
+		float _lodDistances[LOD_LEVELS - 1];	// max distance from the activation region for 1/2, 1/4 rates
+		unsigned int _step;				// fixed steps simulated so far (phase reference)
+		Objects _wokenObjects;			// sleeping objects found in the activation region (reused)
+
+		// spatial snapshots (double buffered)
+		bool _snapshots;								// if true, a snapshot is published at the end of each step
+		std::shared_ptr<SpatialSnapshot> _snapshot;		// last published, read by other threads (atomic access only)
+		std::shared_ptr<SpatialSnapshot> _backSnapshot;	// previous one, rebuilt in place once no reader holds it
+		unsigned int _snapshotVersion;
+		Objects _snapshotObjects;						// reused across snapshots
 
 		// level editor (json) file
 		std::string _jsonPath;
@@ -64,11 +115,19 @@ class agp::GameScene : public Scene
 		virtual void updateControls(float timeToSimulate);
 		virtual void updateWorld(float timeToSimulate);
 		virtual void updateCamera(float timeToSimulate);
+		virtual void updateSpatialIndex(Object* obj);
+		virtual void updateObjects(float dt);			// one step of object updates (logic, animations)
+		virtual Object::UpdateMode defaultUpdateMode(Object* obj);
+		void setUpdateMode(Object* obj, Object::UpdateMode mode, int lodList = -1);
+		Objects* updateList(Object::UpdateMode mode, int lodList);	// nullptr = not in any list
+		int lodList(Object* obj, const RectF& deactivationRect);	// rate by distance, least loaded phase
+		virtual void wakeActivationRegion();			// wakes the sleeping objects in the activation region
+		void wakeSleepingObject(Object* obj);			// to UPDATE_FULL, coarse-ticked ones catch up first
 
 	public:
 
 		GameScene(const RectF& rect, const Point& pixelUnitSize, float dt);
-		virtual ~GameScene() {}
+		virtual ~GameScene();
 
 		Object* player() { return _player; }
 		virtual void setPlayer(Object* player) { _player = player; }
@@ -80,18 +139,55 @@ class agp::GameScene : public Scene
 		virtual void addForegroundScene(OverlayScene* fgScene) { _foregroundScenes.push_back(fgScene); }
 		virtual void displayGameSceneOnly(bool on) { _displayGameSceneOnly = on; }
 		virtual void setAutoKillWhenOutsideScene(bool on) { _autoKillWhenOutsideScene = on; }
-		virtual void setUseQuadtree(bool on) { _useQuadtree = on; }
+		SpatialIndex* spatialIndex() const { return _spatialIndex; }
+		virtual void setSpatialIndex(SpatialIndex* index);
+		virtual void setUseSpatialIndex(bool on) { _useSpatialIndex = on; }
+		virtual void setUseQuadtree(bool on, float looseness = 1);
+		virtual void setUseUniformGrid(bool on, const PointF& cellSize = PointF(0, 0));	// (0,0) = from pixelUnitSize
+		virtual void setUseAABBTree(bool on, float margin = 0.1f);
+		virtual void setUseLinearQuadtree(bool on);		// rebuilt once per step, for scenes where most objects move
+		StaticIndex* staticIndex() const { return _staticIndex; }
+		unsigned int staticCategories() const { return _staticCategories; }
+		const Objects& updatedObjects() const { return _updatedObjects; }
+		const Objects& animatedObjects() const { return _animatedObjects; }
+		bool activation() const { return _activation; }
+		virtual void setActivation(bool on, const PointF& margin = PointF(4, 4), const PointF& hysteresis = PointF(4, 4));
+		virtual void setLodDistances(float half, float quarter);	// from the activation region, farther = 1/8 rate
+		RectF activationRect(bool withHysteresis = false) const;
+		const Objects& frozenObjects() const { return _frozenObjects; }
+		int lodCount(int level) const;		// objects updated at 1/2^level rate (0 = full rate)
+		virtual void setStaticCategories(unsigned int categories);
+		bool deferSpatialUpdates() const { return _deferSpatialUpdates; }
+		virtual void setDeferSpatialUpdates(bool on);
+		virtual void flushMovedObjects();
+		bool bulkLoading() const { return _bulkLoading; }
+		virtual void setBulkLoading(bool on);			// on at construction, off after the first flush
+		virtual void rebuildSpatialIndex();				// end of step: flush + rebuild (see SpatialIndex::rebuild) + snapshot
+		bool snapshots() const { return _snapshots; }
+		virtual void setSnapshots(bool on);
+		virtual void publishSnapshot();
+
+		// last published snapshot (nullptr if snapshots are off), callable from any thread:
+		// the snapshot stays valid as long as the returned pointer is held
+		std::shared_ptr<const SpatialSnapshot> snapshot() const { return std::atomic_load(&_snapshot); }
 		virtual void setJsonPath(const std::string& newPath) { _jsonPath = newPath; }
 
-		// override add/remove objects (+quadtree)
+		// override add/remove objects (+spatial index)
 		virtual void newObject(Object* obj) override;
 		virtual void killObject(Object* obj) override;
-
-		// override geometric queries (+quadtree)
-		virtual Objects objects() override;
-		virtual Objects objects(const RectF& cullingRect) override;
-		virtual Objects objects(const PointF& containPoint) override;
+		virtual void refreshObjects() override;		// flushes pending index updates first
+
+		// override geometric queries (+spatial index)
+		using Scene::objects;
+		using Scene::raycast;
+		virtual void objects(const RectF& cullingRect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) override;
+		virtual void objects(const PointF& containPoint, const ObjectVisitor& visitor) override;
+		virtual void raycast(const LineF& line, RaycastHits& hits) override;
+		virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) override;
+		virtual Objects nearestObjects(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) override;
+		virtual Objects objectsWithin(const PointF& point, float radius, const ObjectFilter& filter = nullptr) override;
 		virtual bool isEmpty(const RectF& rect) override;
+		virtual void intersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) override;
 
 		// override render (+overlay scenes)
 		virtual void render() override;
@@ -102,6 +198,9 @@ class agp::GameScene : public Scene
 		// override event handler (+camera translate/zoom)
 		virtual void event(SDL_Event& evt) override;
 
-		// override object move event (+quadtree)
+		// override object events (+spatial index, +update modes)
 		virtual void objectMoved(Object* obj) override;
+		virtual void objectAdded(Object* obj) override;
+		virtual void objectRemoved(Object* obj) override;
+		virtual void wakeObject(Object* obj) override;
 };
\ No newline at end of file
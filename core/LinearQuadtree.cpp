@@ -0,0 +1,564 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "LinearQuadtree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <iostream>
+#include "Object.h"
+#include "ThreadPool.h"
+
+using namespace agp;
+
+LinearQuadtree::LinearQuadtree(const RectF& rect) :
+    _rect(rect)
+{
+    _dirty = false;
+}
+
+void LinearQuadtree::clear()
+{
+    for (auto obj : _objects)
+        if (obj)
+            _objectToSlot[obj->denseId()] = ObjectEntry();
+    for (auto obj : _pending)
+        _objectToSlot[obj->denseId()] = ObjectEntry();
+
+    _keys.clear();
+    _objects.clear();
+    _pending.clear();
+    _dirty = false;
+}
+
+void LinearQuadtree::add(Object* obj)
+{
+    if (!_rect.contains(obj->rect()))
+    {
+        if (VERBOSE)
+            std::cerr << strprintf("LinearQuadtree::add: index rect (%s) does not fully contain object (%s) rect (%s)", _rect.str().c_str(), obj->name().c_str(), obj->rect().str().c_str());
+        return;
+    }
+
+    if (obj->denseId() >= int(_objectToSlot.size()))
+        _objectToSlot.resize(std::max(std::size_t(obj->denseId() + 1), 2 * _objectToSlot.size()));
+
+    if (_objectToSlot[obj->denseId()].stored())
+    {
+        if (VERBOSE)
+            std::cerr << "LinearQuadtree::add: trying to add an object already present in the index\n";
+        return;
+    }
+
+    addPending(obj);
+}
+
+void LinearQuadtree::remove(Object* obj)
+{
+    ObjectEntry* e = entry(obj);
+    if (!e || !e->stored())
+        return;
+
+    if (e->sorted != -1)
+        _objects[e->sorted] = nullptr;
+    else
+    {
+        // swap with the last pending object and pop back
+        _pending[e->pending] = _pending.back();
+        _objectToSlot[_pending.back()->denseId()].pending = e->pending;
+        _pending.pop_back();
+    }
+    *e = ObjectEntry();
+    _dirty = true;
+}
+
+void LinearQuadtree::update(Object* obj)
+{
+    ObjectEntry* e = entry(obj);
+    if (!e || !e->stored())
+    {
+        if (VERBOSE)
+            std::cerr << "LinearQuadtree::update: trying to update an object [" << obj->name() << ", rect = " << obj->rect().str() << "] that is not present in the index\n";
+        return;
+    }
+
+    // tighter cell at the next rebuild
+    _dirty = true;
+
+    // still within its cell: queries remain exact
+    if (e->sorted == -1 || keyRect(_keys[e->sorted]).contains(obj->rect()))
+        return;
+
+    _objects[e->sorted] = nullptr;
+    e->sorted = -1;
+    addPending(obj);
+}
+
+void LinearQuadtree::addPending(Object* obj)
+{
+    _objectToSlot[obj->denseId()].pending = int(_pending.size());
+    _pending.push_back(obj);
+    _dirty = true;
+}
+
+void LinearQuadtree::rebuild()
+{
+    if (!_dirty)
+        return;
+    _dirty = false;
+
+    // stored (not removed) objects, then pending ones
+    _tmpObjects.clear();
+    for (auto obj : _objects)
+        if (obj)
+            _tmpObjects.push_back(obj);
+    _tmpObjects.insert(_tmpObjects.end(), _pending.begin(), _pending.end());
+    _pending.clear();
+    _objects.swap(_tmpObjects);
+
+    _keys.resize(_objects.size());
+    for (std::size_t i = 0; i < _objects.size(); i++)
+        _keys[i] = key(_objects[i]->rect());
+
+    radixSort();
+
+    for (int i = 0; i < int(_objects.size()); i++)
+    {
+        ObjectEntry& e = _objectToSlot[_objects[i]->denseId()];
+        e.sorted = i;
+        e.pending = -1;
+    }
+}
+
+void LinearQuadtree::radixSort()
+{
+    // LSD radix sort of (key, object) pairs, 8 bits per pass (stable)
+    std::size_t n = _keys.size();
+    _tmpKeys.resize(n);
+    _tmpObjects.resize(n);
+    for (int shift = 0; shift < KEY_BITS; shift += 8)
+    {
+        std::size_t offsets[257] = {};
+        for (std::size_t i = 0; i < n; i++)
+            offsets[((_keys[i] >> shift) & 0xFF) + 1]++;
+        for (int d = 0; d < 256; d++)
+            offsets[d + 1] += offsets[d];
+        for (std::size_t i = 0; i < n; i++)
+        {
+            std::size_t dst = offsets[(_keys[i] >> shift) & 0xFF]++;
+            _tmpKeys[dst] = _keys[i];
+            _tmpObjects[dst] = _objects[i];
+        }
+        _keys.swap(_tmpKeys);
+        _objects.swap(_tmpObjects);
+    }
+}
+
+unsigned int LinearQuadtree::spreadBits(unsigned int v)
+{
+    // 16 bits -> even bits of 32
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+unsigned int LinearQuadtree::compactBits(unsigned int v)
+{
+    // even bits of 32 -> 16 bits
+    v &= 0x55555555;
+    v = (v | (v >> 1)) & 0x33333333;
+    v = (v | (v >> 2)) & 0x0F0F0F0F;
+    v = (v | (v >> 4)) & 0x00FF00FF;
+    v = (v | (v >> 8)) & 0x0000FFFF;
+    return v;
+}
+
+unsigned int LinearQuadtree::key(const RectF& r) const
+{
+    // cells covered at the deepest level (same rule as UniformGrid::cellRange)
+    const int cells = 1 << MAX_DEPTH;
+    float fx = cells / _rect.size.x;
+    float fy = cells / _rect.size.y;
+    int x0 = int(std::floor((r.pos.x - _rect.pos.x) * fx));
+    int y0 = int(std::floor((r.pos.y - _rect.pos.y) * fy));
+    int x1 = std::max(x0, int(std::ceil((r.pos.x + r.size.x - _rect.pos.x) * fx)) - 1);
+    int y1 = std::max(y0, int(std::ceil((r.pos.y + r.size.y - _rect.pos.y) * fy)) - 1);
+    x0 = std::min(std::max(x0, 0), cells - 1);
+    y0 = std::min(std::max(y0, 0), cells - 1);
+    x1 = std::min(std::max(x1, 0), cells - 1);
+    y1 = std::min(std::max(y1, 0), cells - 1);
+
+    // deepest cell containing both corners: drop the bits where they differ
+    unsigned int diff = (x0 ^ x1) | (y0 ^ y1);
+    int shift = 0;
+    while (diff >> shift)
+        shift++;
+
+    unsigned int morton = (spreadBits(x0 >> shift) | (spreadBits(y0 >> shift) << 1)) << (2 * shift);
+    return (morton << LEVEL_BITS) | (MAX_DEPTH - shift);
+}
+
+RectF LinearQuadtree::nodeRect(int level, int x, int y) const
+{
+    float w = _rect.size.x / (1 << level);
+    float h = _rect.size.y / (1 << level);
+    return RectF(_rect.pos.x + x * w, _rect.pos.y + y * h, w, h);
+}
+
+RectF LinearQuadtree::keyRect(unsigned int key) const
+{
+    int level = key & ((1 << LEVEL_BITS) - 1);
+    unsigned int morton = (key >> LEVEL_BITS) >> (2 * (MAX_DEPTH - level));
+    return nodeRect(level, compactBits(morton), compactBits(morton >> 1));
+}
+
+int LinearQuadtree::split(const Node& node, Node children[4]) const
+{
+    // objects stored at the node come first (same morton prefix, lowest level)
+    int shift = MAX_DEPTH - node.level;
+    unsigned int base = (spreadBits(node.x) | (spreadBits(node.y) << 1)) << (2 * shift);
+    unsigned int ownKey = (base << LEVEL_BITS) | node.level;
+    int ownEnd = int(std::upper_bound(_keys.begin() + node.begin, _keys.begin() + node.end, ownKey) - _keys.begin());
+
+    // then the 4 children in Z-order, child i morton = (parent morton << 2) | i
+    unsigned int childSpan = 1u << (2 * (shift - 1));
+    int begin = ownEnd;
+    for (int i = 0; i < 4; i++)
+    {
+        int end = node.end;
+        if (i < 3)
+        {
+            unsigned int childEndKey = (base + (i + 1) * childSpan) << LEVEL_BITS;
+            end = int(std::lower_bound(_keys.begin() + begin, _keys.begin() + node.end, childEndKey) - _keys.begin());
+        }
+        children[i] = { node.level + 1, 2 * node.x + (i & 1), 2 * node.y + (i >> 1), begin, end };
+        begin = end;
+    }
+
+    return ownEnd;
+}
+
+LinearQuadtree::ObjectEntry* LinearQuadtree::entry(const Object* obj)
+{
+    if (obj->denseId() < 0 || obj->denseId() >= int(_objectToSlot.size()))
+        return nullptr;
+
+    return &_objectToSlot[obj->denseId()];
+}
+
+void LinearQuadtree::queryObjects(const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const
+{
+    if (!query(root(), queryRect, visitor, categoryMask))
+        return;
+
+    for (auto obj : _pending)
+        if ((obj->category() & categoryMask) && queryRect.intersects(obj->rect()) && !visitor(obj))
+            return;
+}
+
+bool LinearQuadtree::scan(int begin, int end, const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const
+{
+    for (int i = begin; i < end; i++)
+    {
+        Object* obj = _objects[i];
+        if (obj && (obj->category() & categoryMask) && queryRect.intersects(obj->rect()) && !visitor(obj))
+            return false;
+    }
+    return true;
+}
+
+bool LinearQuadtree::query(const Node& node, const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const
+{
+    if (node.begin == node.end || !queryRect.intersects(nodeRect(node)))
+        return true;
+
+    // few objects left: no need to split further
+    if (node.level == MAX_DEPTH || node.end - node.begin <= LEAF_OBJECTS)
+        return scan(node.begin, node.end, queryRect, visitor, categoryMask);
+
+    Node children[4];
+    int ownEnd = split(node, children);
+    if (!scan(node.begin, ownEnd, queryRect, visitor, categoryMask))
+        return false;
+    for (int i = 0; i < 4; i++)
+        if (!query(children[i], queryRect, visitor, categoryMask))
+            return false;
+
+    return true;
+}
+
+void LinearQuadtree::raycast(const LineF& line, RaycastHits& hits) const
+{
+    raycast(root(), line, hits);
+
+    float tHit;
+    for (auto obj : _pending)
+        if (obj->intersectsLine(line, tHit))
+            hits.emplace_back(obj, tHit);
+}
+
+void LinearQuadtree::raycast(const Node& node, const LineF& line, RaycastHits& hits) const
+{
+    float tEnter, tExit;
+    if (node.begin == node.end || !nodeRect(node).intersectsLine(line.start, line.end, tEnter, tExit))
+        return;
+
+    Node children[4];
+    bool leaf = node.level == MAX_DEPTH || node.end - node.begin <= LEAF_OBJECTS;
+    int ownEnd = leaf ? node.end : split(node, children);
+    float tHit;
+    for (int i = node.begin; i < ownEnd; i++)
+        if (_objects[i] && _objects[i]->intersectsLine(line, tHit))
+            hits.emplace_back(_objects[i], tHit);
+
+    if (!leaf)
+        for (int i = 0; i < 4; i++)
+            raycast(children[i], line, hits);
+}
+
+Object* LinearQuadtree::raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter) const
+{
+    Object* nearest = nullptr;
+    float tBest = std::numeric_limits<float>::infinity();
+
+    float tHit;
+    for (auto obj : _pending)
+        if (obj->intersectsLine(line, tHit) && tHit < tBest && (!filter || filter(obj)))
+        {
+            nearest = obj;
+            tBest = tHit;
+        }
+    raycastNearest(root(), line, filter, nearest, tBest);
+
+    if (nearest)
+        tNear = tBest;
+    return nearest;
+}
+
+void LinearQuadtree::raycastNearest(const Node& node, const LineF& line, const ObjectFilter& filter, Object*& nearest, float& tNear) const
+{
+    // subtrees entered after the nearest hit found so far are skipped
+    float tEnter, tExit;
+    if (node.begin == node.end || !nodeRect(node).intersectsLine(line.start, line.end, tEnter, tExit) || tEnter >= tNear)
+        return;
+
+    Node children[4];
+    bool leaf = node.level == MAX_DEPTH || node.end - node.begin <= LEAF_OBJECTS;
+    int ownEnd = leaf ? node.end : split(node, children);
+    float tHit;
+    for (int i = node.begin; i < ownEnd; i++)
+    {
+        Object* obj = _objects[i];
+        if (obj && obj->intersectsLine(line, tHit) && tHit < tNear && (!filter || filter(obj)))
+        {
+            nearest = obj;
+            tNear = tHit;
+        }
+    }
+
+    if (!leaf)
+        for (int i = 0; i < 4; i++)
+            raycastNearest(children[i], line, filter, nearest, tNear);
+}
+
+std::vector<Object*> LinearQuadtree::queryNearest(const PointF& point, int k, const ObjectFilter& filter, float maxDistance) const
+{
+    NearestCandidates nearest(k, maxDistance);
+    if (k <= 0)
+        return nearest.sorted();
+
+    for (auto obj : _pending)
+        nearest.add(obj, obj->rect().distance(point), filter);
+
+    // best-first: nodes are visited by increasing distance from the point,
+    // until the nearest unvisited node is farther than the k-th candidate
+    typedef std::pair<float, Node> NodeDistance;
+    auto farther = [](const NodeDistance& a, const NodeDistance& b) { return a.first > b.first; };
+    std::priority_queue<NodeDistance, std::vector<NodeDistance>, decltype(farther)> frontier(farther);
+    if (!_keys.empty())
+        frontier.emplace(nodeRect(root()).distance(point), root());
+    while (!frontier.empty())
+    {
+        NodeDistance top = frontier.top();
+        frontier.pop();
+        if (top.first > nearest.bound())
+            break;
+
+        const Node& node = top.second;
+        Node children[4];
+        bool leaf = node.level == MAX_DEPTH || node.end - node.begin <= LEAF_OBJECTS;
+        int ownEnd = leaf ? node.end : split(node, children);
+        for (int i = node.begin; i < ownEnd; i++)
+            if (_objects[i])
+                nearest.add(_objects[i], _objects[i]->rect().distance(point), filter);
+
+        if (!leaf)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                float distance = nodeRect(children[i]).distance(point);
+                if (children[i].begin != children[i].end && distance <= nearest.bound())
+                    frontier.emplace(distance, children[i]);
+            }
+        }
+    }
+
+    return nearest.sorted();
+}
+
+std::vector<Object*> LinearQuadtree::queryRadius(const PointF& point, float radius, const ObjectFilter& filter) const
+{
+    auto objects = std::vector<Object*>();
+    queryRadius(root(), point, radius, filter, objects);
+
+    for (auto obj : _pending)
+        if (obj->rect().distance(point) <= radius && (!filter || filter(obj)))
+            objects.push_back(obj);
+
+    return objects;
+}
+
+void LinearQuadtree::queryRadius(const Node& node, const PointF& point, float radius, const ObjectFilter& filter, std::vector<Object*>& objects) const
+{
+    if (node.begin == node.end || nodeRect(node).distance(point) > radius)
+        return;
+
+    Node children[4];
+    bool leaf = node.level == MAX_DEPTH || node.end - node.begin <= LEAF_OBJECTS;
+    int ownEnd = leaf ? node.end : split(node, children);
+    for (int i = node.begin; i < ownEnd; i++)
+    {
+        Object* obj = _objects[i];
+        if (obj && obj->rect().distance(point) <= radius && (!filter || filter(obj)))
+            objects.push_back(obj);
+    }
+
+    if (!leaf)
+        for (int i = 0; i < 4; i++)
+            queryRadius(children[i], point, radius, filter, objects);
+}
+
+void LinearQuadtree::queryIntersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    pairs.clear();
+
+    // independent tasks, each filling its own buffer: nodes above PARALLEL_DEPTH
+    // (their own objects only), whole subtrees rooted at PARALLEL_DEPTH, pending objects
+    _intersectionTasks.clear();
+    if (!_keys.empty())
+        collectIntersectionTasks(root(), 0);
+    int tasks = int(_intersectionTasks.size()) + 1;
+    if (_taskPairs.size() < std::size_t(tasks))
+        _taskPairs.resize(tasks);
+
+    ThreadPool::instance()->parallelFor(tasks, [&](int i)
+        {
+            _taskPairs[i].clear();
+            if (i == tasks - 1)
+                pendingIntersections(_taskPairs[i], categoryMask, activeMask);
+            else if (_intersectionTasks[i].second)
+                queryIntersections(_intersectionTasks[i].first, _taskPairs[i], categoryMask, activeMask);
+            else
+                nodeIntersections(_intersectionTasks[i].first, _taskPairs[i], categoryMask, activeMask);
+        });
+
+    for (int i = 0; i < tasks; i++)
+        pairs.insert(pairs.end(), _taskPairs[i].begin(), _taskPairs[i].end());
+    sortPairs(pairs);
+}
+
+void LinearQuadtree::collectIntersectionTasks(const Node& node, int depth) const
+{
+    if (node.begin == node.end)
+        return;
+
+    if (depth == PARALLEL_DEPTH || node.level == MAX_DEPTH || node.end - node.begin <= LEAF_OBJECTS)
+        _intersectionTasks.emplace_back(node, true);
+    else
+    {
+        _intersectionTasks.emplace_back(node, false);
+        Node children[4];
+        split(node, children);
+        for (int i = 0; i < 4; i++)
+            collectIntersectionTasks(children[i], depth + 1);
+    }
+}
+
+void LinearQuadtree::queryIntersections(const Node& node, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    if (node.begin == node.end)
+        return;
+
+    nodeIntersections(node, pairs, categoryMask, activeMask);
+    if (node.level < MAX_DEPTH && node.end - node.begin > LEAF_OBJECTS)
+    {
+        Node children[4];
+        split(node, children);
+        for (int i = 0; i < 4; i++)
+            queryIntersections(children[i], pairs, categoryMask, activeMask);
+    }
+}
+
+void LinearQuadtree::nodeIntersections(const Node& node, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    // small subtrees are a single group: all pairs are tested
+    Node children[4];
+    bool leaf = node.level == MAX_DEPTH || node.end - node.begin <= LEAF_OBJECTS;
+    int ownEnd = leaf ? node.end : split(node, children);
+
+    for (int i = node.begin; i < ownEnd; i++)
+    {
+        Object* obj = _objects[i];
+        if (!obj || !(obj->category() & categoryMask))
+            continue;
+
+        // an inactive object only pairs with active ones
+        unsigned int otherMask = (obj->category() & activeMask) ? ALL_CATEGORIES : activeMask;
+        auto addPair = [&](Object* other)
+        {
+            if (other->category() & otherMask)
+                pairs.emplace_back(obj, other);
+            return true;
+        };
+
+        // the following objects of the group (each pair found once), then descendants
+        scan(i + 1, ownEnd, obj->rect(), addPair, categoryMask);
+        if (!leaf)
+            for (int c = 0; c < 4; c++)
+                query(children[c], obj->rect(), addPair, categoryMask);
+    }
+}
+
+void LinearQuadtree::pendingIntersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    // pending objects vs. sorted objects, and vs. the following pending objects
+    for (std::size_t i = 0; i < _pending.size(); i++)
+    {
+        Object* obj = _pending[i];
+        if (!(obj->category() & categoryMask))
+            continue;
+
+        unsigned int otherMask = (obj->category() & activeMask) ? ALL_CATEGORIES : activeMask;
+        auto addPair = [&](Object* other)
+        {
+            if (other->category() & otherMask)
+                pairs.emplace_back(obj, other);
+            return true;
+        };
+
+        query(root(), obj->rect(), addPair, categoryMask);
+        for (std::size_t j = i + 1; j < _pending.size(); j++)
+            if ((_pending[j]->category() & categoryMask) && obj->rect().intersects(_pending[j]->rect()))
+                addPair(_pending[j]);
+    }
+}
@@ -0,0 +1,113 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "geometryUtils.h"
+#include "SpatialIndex.h"
+
+namespace agp
+{
+    class Object;
+    class LinearQuadtree;
+}
+
+// Linear (pointerless) quadtree class
+// - container for game objects, rebuilt from scratch once per step: suited for scenes
+//   where most objects move every step (incremental remove/add is the worst case there)
+// - each object is keyed by the deepest quadtree cell containing its rect:
+//   key = Z-order (Morton) code of the cell, then level
+// - keys are radix sorted, so that each subtree is a contiguous range of the sorted
+//   array (found by binary search): no node is ever stored
+// - between rebuilds, update() is O(1): objects that leave their cell are moved to a
+//   small list scanned linearly by queries, so queries are always exact
+// - object-to-slot lookup is a flat table indexed by dense object id (see Object::denseId)
+class agp::LinearQuadtree : public SpatialIndex
+{
+    private:
+
+        // parameters
+        static constexpr int MAX_DEPTH = 12;            // 4096 x 4096 cells at the deepest level
+        static constexpr int LEVEL_BITS = 4;            // key = (morton << LEVEL_BITS) | level
+        static constexpr int KEY_BITS = 2 * MAX_DEPTH + LEVEL_BITS;
+        static constexpr int LEAF_OBJECTS = 8;          // subtrees with fewer objects are scanned linearly
+        static constexpr int PARALLEL_DEPTH = 2;        // subtrees rooted at this depth are broadphase tasks
+        static constexpr bool VERBOSE = false;
+
+        // inner classes/structs
+        struct Node
+        {
+            int level;          // 0 = root
+            int x, y;           // cell coordinates at this level
+            int begin, end;     // subtree range in the sorted arrays
+        };
+        struct ObjectEntry
+        {
+            int sorted = -1;    // index in the sorted arrays (-1 = not there)
+            int pending = -1;   // index in the pending objects (-1 = not there)
+            bool stored() const { return sorted != -1 || pending != -1; }
+        };
+
+        // attributes
+        RectF _rect;
+        std::vector<unsigned int> _keys;        // sorted
+        std::vector<Object*> _objects;          // sorted by key (nullptr = removed or pending)
+        std::vector<Object*> _pending;          // added or moved out of their cell since the last rebuild
+        std::vector<ObjectEntry> _objectToSlot; // indexed by dense object id
+        bool _dirty;
+        std::vector<unsigned int> _tmpKeys;     // radix sort buffers
+        std::vector<Object*> _tmpObjects;
+        mutable std::vector<std::pair<Node, bool>> _intersectionTasks;  // (node, whole subtree), reused across queries
+        mutable std::vector<ObjectPairs> _taskPairs;                    // one buffer per task (+ pending objects), reused across queries
+
+        // helper functions
+        static unsigned int spreadBits(unsigned int v);
+        static unsigned int compactBits(unsigned int v);
+        unsigned int key(const RectF& r) const;
+        RectF nodeRect(int level, int x, int y) const;
+        RectF nodeRect(const Node& node) const { return nodeRect(node.level, node.x, node.y); }
+        RectF keyRect(unsigned int key) const;
+        Node root() const { return { 0, 0, 0, 0, int(_keys.size()) }; }
+        int split(const Node& node, Node children[4]) const;
+        void radixSort();
+        ObjectEntry* entry(const Object* obj);
+        void addPending(Object* obj);
+        bool query(const Node& node, const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const;
+        bool scan(int begin, int end, const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const;
+        void raycast(const Node& node, const LineF& line, RaycastHits& hits) const;
+        void raycastNearest(const Node& node, const LineF& line, const ObjectFilter& filter, Object*& nearest, float& tNear) const;
+        void queryRadius(const Node& node, const PointF& point, float radius, const ObjectFilter& filter, std::vector<Object*>& objects) const;
+        void collectIntersectionTasks(const Node& node, int depth) const;
+        void queryIntersections(const Node& node, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+        void nodeIntersections(const Node& node, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+        void pendingIntersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+
+    public:
+
+        LinearQuadtree(const RectF& rect);
+        virtual RectF rect() const override { return _rect; }
+
+        virtual void add(Object* obj) override;
+        virtual void remove(Object* obj) override;
+        virtual void update(Object* obj) override;
+        virtual void clear() override;
+        virtual void rebuild() override;
+
+        using SpatialIndex::queryObjects;
+        virtual void queryObjects(const RectF& rect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) const override;
+        virtual void raycast(const LineF& line, RaycastHits& hits) const override;
+        virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) const override;
+        virtual std::vector<Object*> queryNearest(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) const override;
+        virtual std::vector<Object*> queryRadius(const PointF& point, float radius, const ObjectFilter& filter = nullptr) const override;
+        virtual void queryIntersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const override;
+
+        // debugging
+        std::size_t pendingCount() const { return _pending.size(); }
+};
@@ -19,14 +19,37 @@ Object::Object(Scene* scene, const RectF& rect, int layer)
 	_scene = scene;
 	_rect = rect;
 	_layer = layer;
+	_category = DEFAULT_CATEGORY;
 	_id = created++;
 	_freezed = false;
 	_killed = false;
-	_itersFromKilled = 0;
+	_sceneIndex = NOT_IN_SCENE;
+	_layerRank = -1;
+	_classIds = 0;
+	_updateMode = UPDATE_NONE;
+	_updateSlot = -1;
+	_activationPolicy = ALWAYS_ACTIVE;
+	_lodList = -1;
+	_lodStep = 0;
 	_scene->newObject(this);
 	_timeElapsed = 0;
 }
 
+Object::~Object()
+{
+	_scene->objectTimers().unscheduleAll(_timers);
+}
+
+void Object::setLayer(int newLayer)
+{
+	if (newLayer == _layer)
+		return;
+
+	_layer = newLayer;
+	if (_sceneIndex != NOT_IN_SCENE)
+		_scene->objectLayerChanged(this);
+}
+
 void Object::setRect(const RectF& newRect) 
 { 
 	if (newRect != _rect)
@@ -47,36 +70,48 @@ void Object::setPos(const PointF& newPos)
 	}
 }
 
-void Object::update(float dt)
+void Object::setFreezed(bool on)
 {
-	_timeElapsed += dt;
+	_freezed = on;
 
-	if (_killed)
-		_itersFromKilled++;
+	// timers stop counting down while the object does not run
+	_scene->objectTimers().setPaused(_timers, !TimerWheel::running(this));
+}
 
-	auto iter = _schedulers.begin();
-	for (; iter != _schedulers.end(); )
+void Object::setCategory(unsigned int newCategory)
+{
+	if (newCategory != _category)
 	{
-		if (iter->second.on())
-		{
-			iter->second.update(dt);
-			++iter;
-		}
-		else
-			iter = _schedulers.erase(iter);
+		_category = newCategory;
+
+		// spatial indices keep per-node category masks
+		_scene->objectMoved(this);
 	}
 }
 
+void Object::update(float dt)
+{
+	_timeElapsed += dt;
+}
+
 void Object::schedule(const std::string& id, float delaySeconds, std::function<void()> action, int loop, bool overwrite)
 {
-	if (overwrite || _schedulers.find(id) == _schedulers.end())
-		_schedulers[id] = Scheduler(delaySeconds, action, loop);
+	schedule(TimerWheel::intern(id), delaySeconds, action, loop, overwrite);
+}
+
+void Object::schedule(TimerId id, float delaySeconds, std::function<void()> action, int loop, bool overwrite)
+{
+	_scene->objectTimers().schedule(_timers, this, id, delaySeconds, action, loop, overwrite);
 }
 
 void Object::unschedule(const std::string& id)
 {
-	if (_schedulers.find(id) != _schedulers.end())
-		_schedulers.erase(id);
+	unschedule(TimerWheel::intern(id));
+}
+
+void Object::unschedule(TimerId id)
+{
+	_scene->objectTimers().unschedule(_timers, id);
 }
 
 void Object::kill()
@@ -9,22 +9,33 @@
 
 #pragma once
 #include <map>
-#include "Scheduler.h"
+#include <type_traits>
+#include "TimerWheel.h"
 #include "stringUtils.h"
 #include "geometryUtils.h"
+#include "ObjectHandle.h"
 
 namespace agp
 {
 	class Scene;
 	class Object;
+
+	// compile-time class ids for RTTI-free type tests (see Object::to)
+	// - a registered class specializes ClassId with a bit unique within its executable
+	//   (0-15 core classes, 16-63 game classes) and calls addClassId in its constructors
+	// - unregistered classes are tested with dynamic_cast
+	template <class T>
+	struct ClassId { static constexpr int bit = -1; };
 }
 
 // Object (or game object, or entity, or actor) abstract class.
 // Suitable for monolithic class hierarchies in simple 2D games.
 // - auto-adds itself to the scene
 // - stores object rect (position and size)
-// - stores schedulers for action scripting
-// - stores object layer in the scene (useful for sorting e.g. for Painter's algorithm)
+// - stores timers for action scripting (run by the scene timing wheel, see TimerWheel)
+// - stores object layer in the scene (useful for sorting e.g. for Painter's algorithm),
+//   and the rank of its layer among the scene layers (see Scene::layerCount)
+// - stores object category bitmask, so that scene queries can skip unwanted objects
 // - stores general state flags
 // - offers update and schedule methods, and simple geometric queries
 class agp::Object
@@ -37,19 +48,69 @@ class agp::Object
 
 		Scene* _scene;
 		int _layer;
+		unsigned int _category;	// category bitmask (one bit per category)
 		int _id;
 		bool _freezed;	// if false, does not update
 		bool _killed;
-		int _itersFromKilled;
+		int _sceneIndex;		// slot in the scene objects vector (or NOT_IN_SCENE, SPAWNING)
+		int _layerRank;			// rank of _layer among the scene layers (-1 if not in the scene, assigned at spawn)
+		ObjectHandle _handle;	// assigned by the scene
+		unsigned long long _classIds;	// registered classes this object is an instance of (see ClassId)
+		int _updateMode;		// per-step update participation (see UpdateMode, managed by GameScene)
+		int _updateSlot;		// slot in the GameScene list of the update mode
+		int _activationPolicy;	// behavior out of the GameScene activation region (see ActivationPolicy)
+		int _lodList;			// GameScene reduced-rate list (rate bucket and phase), if UPDATE_COARSE
+		unsigned int _lodStep;	// GameScene step of the last update, if UPDATE_COARSE
 		float _timeElapsed;		// internal usage to keep track of elapsed time
-		std::map<std::string, Scheduler> _schedulers;
+		TimerWheel::Timers _timers;	// pending timers (in the scene object timers)
 
 		friend class Scene;
+		friend class GameScene;
+
+		// to be called by constructors of registered classes
+		template <class T>
+		void addClassId()
+		{
+			static_assert(ClassId<T>::bit >= 0 && ClassId<T>::bit < 64, "class not registered (see ClassId)");
+			_classIds |= 1ull << ClassId<T>::bit;
+		}
+
+	private:
+
+		template <class T>
+		T toRegistered(std::true_type)
+		{
+			typedef typename std::remove_cv<typename std::remove_pointer<T>::type>::type Class;
+			return (_classIds & (1ull << ClassId<Class>::bit)) ? static_cast<T>(this) : nullptr;
+		}
+		template <class T>
+		T toRegistered(std::false_type) { return dynamic_cast<T>(this); }
 
 	public:
 
+		static constexpr int NOT_IN_SCENE = -1;
+		static constexpr int SPAWNING = -2;	// waiting to be added at the next scene refresh
+
+		// per-step update participation
+		enum UpdateMode
+		{
+			UPDATE_NONE,		// not updated (e.g. static bodies)
+			UPDATE_FULL,		// update() every step
+			UPDATE_SPRITE,		// sprite tick only (e.g. animated static bodies)
+			UPDATE_FROZEN,		// sleeping out of the activation region, not updated
+			UPDATE_COARSE		// sleeping out of the activation region, updated at a reduced rate
+		};
+
+		// behavior out of the GameScene activation region (per class, set by constructors)
+		enum ActivationPolicy
+		{
+			ALWAYS_ACTIVE,		// updated everywhere (default, e.g. player, projectiles)
+			FREEZE,				// not updated, nor its scheduled actions
+			COARSE_TICK			// updated at 1/2, 1/4 or 1/8 rate (by distance) with the accumulated dt
+		};
+
 		Object(Scene* scene, const RectF& rect, int layer = 0);
-		virtual ~Object() {}
+		virtual ~Object();
 
 		// getters/setters
 		const RectF& rect() const { return _rect; }
@@ -59,12 +120,20 @@ class agp::Object
 		PointF size() const { return _rect.size; }
 		virtual void setSize(const PointF& newSize) { _rect.size = newSize; }
 		int layer() const { return _layer; }
-		virtual void setLayer(int newLayer) { _layer = newLayer; }
+		virtual void setLayer(int newLayer);
+		int layerRank() const { return _layerRank; }
+		unsigned int category() const { return _category; }
+		virtual void setCategory(unsigned int newCategory);
 		bool freezed() const { return _freezed; }
-		virtual void setFreezed(bool on) { _freezed = on; }
-		void toggleFreezed() { _freezed = !_freezed; }
+		virtual void setFreezed(bool on);
+		void toggleFreezed() { setFreezed(!_freezed); }
 		Scene* scene() const { return _scene; }
 		bool killed() const { return _killed; }
+		const ObjectHandle& handle() const { return _handle; }
+		int denseId() const { return int(_handle.index); }	// handle slot: unique in the scene, reused once deallocated (for lookup tables)
+		UpdateMode updateMode() const { return UpdateMode(_updateMode); }
+		ActivationPolicy activationPolicy() const { return ActivationPolicy(_activationPolicy); }
+		virtual void setActivationPolicy(ActivationPolicy policy) { _activationPolicy = policy; }
 
 		// geometric queries
 		virtual bool contains(const Vec2Df& p) { return _rect.contains(p); }
@@ -75,13 +144,25 @@ class agp::Object
 		// core game logic (physics, ...)
 		virtual void update(float dt);
 
-		// scheduling
+		// scheduling (interned ids skip the name lookup, e.g. for actions scheduled every step)
 		virtual void schedule(const std::string& id, float delaySeconds, std::function<void()> action, int loop = 0, bool overwrite = true);
+		virtual void schedule(TimerId id, float delaySeconds, std::function<void()> action, int loop = 0, bool overwrite = true);
 		virtual void unschedule(const std::string& id);
+		virtual void unschedule(TimerId id);
+		bool scheduled(TimerId id) const { return TimerWheel::scheduled(_timers, id); }
+		bool hasTimers() const { return !_timers.empty(); }
 
-		// type conversion
+		// type conversion (T = pointer type) and type test (T = class type)
+		// - registered classes (see ClassId): bitmask test + static_cast
+		// - others: dynamic_cast
+		template <class T>
+		T to()
+		{
+			typedef typename std::remove_cv<typename std::remove_pointer<T>::type>::type Class;
+			return toRegistered<T>(std::integral_constant<bool, (ClassId<Class>::bit >= 0)>());
+		}
 		template <class T>
-		T to() { return dynamic_cast<T>(this); }
+		bool is() { return to<T*>() != nullptr; }
 
 		// kill
 		virtual void kill();
@@ -0,0 +1,34 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+namespace agp
+{
+	struct ObjectHandle;
+}
+
+// Object handle (generational)
+// - weak reference to a scene object: slot in the scene handle table + slot generation
+// - resolved in O(1) by Scene::object(), which returns nullptr once the object has been
+//   deallocated: the slot generation is incremented then, so handles to a reused slot
+//   (or to pooled memory now holding another object) can never reach the new object
+// - killed objects still resolve until deallocated (check Object::killed() as usual)
+// - valid only within the scene of the object
+// - default-constructed = null handle (slot generations start from 1)
+struct agp::ObjectHandle
+{
+	unsigned int index = 0;
+	unsigned int generation = 0;
+
+	bool null() const { return generation == 0; }
+	bool operator==(const ObjectHandle& h) const { return index == h.index && generation == h.generation; }
+	bool operator!=(const ObjectHandle& h) const { return !(*this == h); }
+	bool operator<(const ObjectHandle& h) const { return index != h.index ? index < h.index : generation < h.generation; }
+};
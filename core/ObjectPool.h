@@ -0,0 +1,133 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace agp
+{
+    template <typename T, std::size_t ChunkSize>
+    class ObjectPool;
+
+    template <typename T, std::size_t ChunkSize = 64>
+    class Pooled;
+}
+
+// Object pool class template
+// - per-class storage for short-lived objects (projectiles, effects, their sprites):
+//   slots are carved from contiguous chunks of ChunkSize objects and recycled through
+//   a free list, so steady-state spawn/kill cycles do no allocator work
+// - LIFO reuse: the most recently freed (cache-hot) slot is handed out first
+// - memory only, objects are still constructed and destructed on each reuse: the
+//   constructor is the reinit hook, the destructor is the reset hook (must release
+//   whatever the object owns, e.g. its sprite)
+// - chunks are never returned to the heap, reserve() pre-warms capacity (e.g. at level load)
+// - single-threaded, like object creation and deletion in scenes
+template <typename T, std::size_t ChunkSize>
+class agp::ObjectPool
+{
+    private:
+
+        union Slot
+        {
+            Slot* next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        std::vector<Slot*> _chunks;
+        Slot* _free;
+        std::size_t _used;
+
+        ObjectPool() : _free(nullptr), _used(0) {}
+
+        void grow()
+        {
+            Slot* chunk = static_cast<Slot*>(::operator new(ChunkSize * sizeof(Slot)));
+            _chunks.push_back(chunk);
+            for (std::size_t i = ChunkSize; i > 0; i--)
+            {
+                chunk[i - 1].next = _free;
+                _free = &chunk[i - 1];
+            }
+        }
+
+    public:
+
+        // never destroyed: objects may be deleted during static deinitialization
+        static ObjectPool* instance()
+        {
+            static ObjectPool* pool = new ObjectPool();
+            return pool;
+        }
+
+        void* allocate()
+        {
+            if (!_free)
+                grow();
+            Slot* slot = _free;
+            _free = slot->next;
+            _used++;
+            return slot;
+        }
+
+        void deallocate(void* p)
+        {
+            Slot* slot = static_cast<Slot*>(p);
+            slot->next = _free;
+            _free = slot;
+            _used--;
+        }
+
+        // ensures at least 'count' objects can be allocated without growing
+        void reserve(std::size_t count)
+        {
+            while (capacity() < count)
+                grow();
+        }
+
+        std::size_t capacity() const { return _chunks.size() * ChunkSize; }
+        std::size_t used() const { return _used; }
+};
+
+// Pooled mixin class template
+// - routes T allocations (new/delete) to ObjectPool<T>, e.g.
+//   class Hammer : public Enemy, public Pooled<Hammer>
+// - subclasses of T with a different size fall back to the global heap
+// - if a base class is pooled too, T must pick its own operators with
+//   using Pooled<T>::operator new; using Pooled<T>::operator delete;
+template <typename T, std::size_t ChunkSize>
+class agp::Pooled
+{
+    public:
+
+        static void* operator new(std::size_t size)
+        {
+            if (size != sizeof(T))
+                return ::operator new(size);
+            return ObjectPool<T, ChunkSize>::instance()->allocate();
+        }
+
+        static void operator delete(void* p, std::size_t size)
+        {
+            if (size != sizeof(T))
+                ::operator delete(p);
+            else
+                ObjectPool<T, ChunkSize>::instance()->deallocate(p);
+        }
+
+        // pre-warms the pool
+        static void reservePool(std::size_t count) { ObjectPool<T, ChunkSize>::instance()->reserve(count); }
+
+        // debugging
+        static std::size_t pooledCapacity() { return ObjectPool<T, ChunkSize>::instance()->capacity(); }
+        static std::size_t pooledCount() { return ObjectPool<T, ChunkSize>::instance()->used(); }
+};
@@ -0,0 +1,58 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "OffscreenWindow.h"
+
+using namespace agp;
+
+OffscreenWindow::OffscreenWindow(const std::string& title, int width, int height)
+	: Window(title, width, height, false)
+{
+	_surface = nullptr;
+}
+
+OffscreenWindow::~OffscreenWindow()
+{
+	// the renderer draws on the surface: destroyed first
+	if (_renderer)
+		SDL_DestroyRenderer(_renderer);
+	_renderer = nullptr;
+	if (_surface)
+		SDL_FreeSurface(_surface);
+}
+
+void OffscreenWindow::initWindow()
+{
+	_surface = SDL_CreateRGBSurfaceWithFormat(0, _width, _height, 32, SDL_PIXELFORMAT_RGBA32);
+	if (!_surface)
+		throw SDL_GetError();
+}
+
+void OffscreenWindow::initRenderer()
+{
+	_renderer = SDL_CreateSoftwareRenderer(_surface);
+	if (!_renderer)
+		throw SDL_GetError();
+
+	SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_BLEND);
+}
+
+void OffscreenWindow::resize(int newWidth, int newHeight)
+{
+	if (newWidth == _width && newHeight == _height)
+		return;
+
+	_width = newWidth;
+	_height = newHeight;
+
+	SDL_DestroyRenderer(_renderer);
+	SDL_FreeSurface(_surface);
+	initWindow();
+	initRenderer();
+}
@@ -0,0 +1,41 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include "Window.h"
+
+namespace agp
+{
+	class OffscreenWindow;
+}
+
+// OffscreenWindow class
+// - renders into a memory surface with SDL's software renderer
+// - needs no SDL video (no display, no window): for tests and benchmarks
+class agp::OffscreenWindow : public agp::Window
+{
+	protected:
+
+		SDL_Surface* _surface;		// render target
+
+		// override (memory surface instead of window)
+		virtual void initWindow() override;
+		virtual void initRenderer() override;
+
+	public:
+
+		OffscreenWindow(const std::string& title, int width, int height);
+		virtual ~OffscreenWindow();
+
+		// rendered frame
+		SDL_Surface* surface() { return _surface; }
+
+		// override (+surface and renderer reallocation)
+		virtual void resize(int newWidth, int newHeight) override;
+};
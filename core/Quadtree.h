@@ -7,63 +7,63 @@
 // See LICENSE in root directory for full details.
 // ----------------------------------------------------------------
 
+
 #pragma once
 
-#include <array>
 #include <vector>
-#include <map>
 #include "geometryUtils.h"
+#include "SpatialIndex.h"
+#include "BasicQuadtree.h"
+#include "Object.h"
 
 namespace agp
 {
-    class Object;
     class Quadtree;
 }
 
-// Quadtree (standard/scrict) class
-// - container for game objects stored according to spatial partitioning
-// - objects are stored in the smallest node that entirely contains its rect
-// - provides efficient spatial queries for game scenes
-
-class agp::Quadtree
+// Quadtree (standard/scrict or loose) class
+// - spatial index of game objects: BasicQuadtree instantiated for Object*
+//   (see BasicQuadtree for the structure, loose mode, bulk loading and broadphase)
+// - object bounds, ids and categories are inlined accessors (no virtual calls),
+//   raycasts use Object::intersectsLine (objects may refine the rect test)
+class agp::Quadtree : public SpatialIndex
 {
     private:
 
-        // parameters
-        static constexpr int MAX_OBJECTS_PER_NODE = 16;
-        static constexpr int MAX_DEPTH = 8;
-        static constexpr bool VERBOSE = false;
-
-        // inner classes/structs
-        struct Node;
+        // Object* accessors used by the template
+        struct ObjectTraits
+        {
+            static const RectF& rect(Object* const& obj) { return obj->rect(); }
+            static int id(Object* const& obj) { return obj->id(); }
+            static int denseId(Object* const& obj) { return obj->denseId(); }
+            static unsigned int category(Object* const& obj) { return obj->category(); }
+            static bool intersectsLine(Object* const& obj, const LineF& line, float& tHit) { return obj->intersectsLine(line, tHit); }
+        };
 
         // attributes
-        RectF _rect;
-        Node* _root;
-        std::map<int, Node*> _objectToNode;
-
-        // helper functions
-        bool isLeaf(const Node* node) const;
-        RectF indexToQuadrant(const RectF& rect, int i) const;
-        int getObjectQuadrant(const RectF& quadRect, const RectF& objRect) const;
-        void add(Node* node, std::size_t depth, const RectF& nodeRect, Object* obj);
-        void split(Node* node, const RectF& nodeRect);
-        void nodeAddObject(Node* node, Object* obj);
-        void nodeRemoveObject(Node* node, Object* obj);
-        bool tryMerge(Node* node);
-        void query(Node* node, const RectF& nodeRect, const RectF& queryRect, std::vector<Object*>& objects) const;
-        void queryIntersections(Node* node, std::vector<std::pair<Object*, Object*>>& intersections) const;
-        void queryIntersectionsInDescendants(Node* node, Object* obj, std::vector<std::pair<Object*, Object*>>& intersections) const;
+        BasicQuadtree<Object*, ObjectTraits> _tree;
 
     public:
 
-        Quadtree(const RectF& rect);
-        RectF rect() const { return _rect; }
+        Quadtree(const RectF& rect, float looseness = 1);
+        virtual RectF rect() const override { return _tree.rect(); }
+        float looseness() const { return _tree.looseness(); }
+        void setLooseness(float looseness);
+
+        virtual void add(Object* obj) override;
+        virtual void remove(Object* obj) override;
+        virtual void update(Object* obj) override;
+        virtual void clear() override;
+        virtual void bulkLoad(const std::vector<Object*>& objects) override;
 
-        void add(Object* obj);
-        void remove(Object* obj);
-        void update(Object* obj);
+        using SpatialIndex::queryObjects;
+        virtual void queryObjects(const RectF& rect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) const override;
+        virtual void raycast(const LineF& line, RaycastHits& hits) const override;
+        virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) const override;
+        virtual std::vector<Object*> queryNearest(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) const override;
+        virtual std::vector<Object*> queryRadius(const PointF& point, float radius, const ObjectFilter& filter = nullptr) const override;
+        virtual void queryIntersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const override;
 
-        std::vector<Object*> queryObjects(const RectF& rect) const;
-        std::vector<std::pair<Object*, Object*>> queryIntersections() const;
-};
+        // debugging
+        std::size_t nodesCount() const { return _tree.nodesCount(); }
+};
\ No newline at end of file
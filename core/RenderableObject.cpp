@@ -16,6 +16,7 @@ using namespace agp;
 RenderableObject::RenderableObject(Scene* scene, const RectF& rect, const Color& color, int layer)
 	: Object(scene, rect, layer)
 {
+	addClassId<RenderableObject>();
 	_color = color;
 	_fit = true;
 	_flip = SDL_FLIP_NONE;
@@ -34,6 +35,7 @@ RenderableObject::RenderableObject(Scene* scene, const RectF& rect, const Color&
 RenderableObject::RenderableObject(Scene* scene, const RectF& rect, Sprite* sprite, int layer, bool fit)
 	: Object(scene, rect, layer)
 {
+	addClassId<RenderableObject>();
 	_color = { 0,0,0,0 };
 	_fit = fit;
 	_flip = SDL_FLIP_NONE;
@@ -126,4 +128,9 @@ void RenderableObject::setSprite(Sprite* sprite, bool deallocateSprite, bool res
 	}
 
 	_sprite = sprite; 
+
+	// objects not updated each step are reclassified (e.g. now animated),
+	// unless out of the scene (e.g. sprite released by the destructor)
+	if (_updateMode != UPDATE_FULL && _sceneIndex >= 0)
+		_scene->wakeObject(this);
 }
\ No newline at end of file
@@ -16,6 +16,7 @@ namespace agp
 {
 	class Scene;
 	class RenderableObject;
+	template <> struct ClassId<RenderableObject> { static constexpr int bit = 0; };
 }
 
 // RenderableObject class.
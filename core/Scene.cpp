@@ -25,6 +25,7 @@ Scene::Scene(const RectF& rect, const Point& pixelUnitSize)
 	_blocking = false;
 	_view = nullptr;
 	_rectsVisible = false;
+	_emptyLayers = 0;
 }
 
 Scene::~Scene()
@@ -35,87 +36,190 @@ Scene::~Scene()
 
 void Scene::newObject(Object* obj)
 {
-	_newObjects.insert(obj);
+	if (obj->_sceneIndex != Object::NOT_IN_SCENE)
+		return;
+
+	obj->_sceneIndex = Object::SPAWNING;
+	_newObjects.push_back(obj);
+
+	// layer rank assigned right away: spawning objects can already be queried (e.g. by views)
+	joinLayer(obj);
+
+	// handle slot (reused slots keep their generation)
+	if (_freeHandles.empty())
+	{
+		_freeHandles.push_back((unsigned int)(_handles.size()));
+		_handles.push_back({ nullptr, 1 });
+	}
+	unsigned int index = _freeHandles.back();
+	_freeHandles.pop_back();
+	_handles[index].object = obj;
+	obj->_handle = { index, _handles[index].generation };
 }
 
 void Scene::killObject(Object* obj)
 {
-	_deadObjects.insert(obj);
+	if (obj->_killed)
+		return;
+
+	_deadObjects.push_back(obj);
 	obj->_killed = true;
 }
 
 void Scene::refreshObjects()
 {
+	// new objects are appended in spawn order
 	for (auto& obj : _newObjects)
-		_objects.emplace_back(obj);
+	{
+		obj->_sceneIndex = int(_objects.size());
+		_objects.push_back(obj);
+		objectAdded(obj);
+	}
 	_newObjects.clear();
 
-	for (auto it = _deadObjects.begin(); it != _deadObjects.end(); )
+	// dead objects are deallocated in kill order (handles to them resolve to nullptr from now on)
+	// note: size re-read at each iteration since destructors may kill other objects, which
+	// are deallocated here as well unless still spawning (kept for the next refresh)
+	size_t kept = 0;
+	for (size_t i = 0; i < _deadObjects.size(); i++)
 	{
-		Object* obj = *it;
+		Object* obj = _deadObjects[i];
 
-		if (obj->_itersFromKilled < 2)
+		if (obj->_sceneIndex == Object::SPAWNING)
 		{
-			++it;
+			_deadObjects[kept++] = obj;
 			continue;
 		}
 
-		auto jt = std::find(_objects.begin(), _objects.end(), obj);
-		if (jt != _objects.end()) 
-		{
-			size_t idxToRemove = std::distance(_objects.begin(), jt);
-			_objects[idxToRemove] = _objects.back();
-			_objects.pop_back();
-		}
+		// O(1) removal: the last object takes the freed slot
+		Object* last = _objects.back();
+		_objects[obj->_sceneIndex] = last;
+		last->_sceneIndex = obj->_sceneIndex;
+		_objects.pop_back();
+
+		// out of the scene: hooks triggered from here on (e.g. by its destructor) ignore it
+		obj->_sceneIndex = Object::NOT_IN_SCENE;
+		leaveLayer(obj);
+		objectRemoved(obj);
+
+		// invalidates all handles to the object (0 is the null generation)
+		HandleSlot& slot = _handles[obj->_handle.index];
+		slot.object = nullptr;
+		if (++slot.generation == 0)
+			slot.generation = 1;
+		_freeHandles.push_back(obj->_handle.index);
 
-		// Erase the element from the set and advance the iterator safely
-		it = _deadObjects.erase(it); // 'erase' returns an iterator to the next element
 		delete obj;
 	}
+	_deadObjects.resize(kept);
 }
 
-std::vector<Object*> Scene::objects()
+void Scene::joinLayer(Object* obj)
 {
-	return _objects;
+	auto iter = std::lower_bound(_layers.begin(), _layers.end(), obj->_layer);
+	int rank = int(iter - _layers.begin());
+
+	// new layer: the ranks above shift up (rare, since layers in use are kept)
+	if (iter == _layers.end() || *iter != obj->_layer)
+	{
+		_layers.insert(iter, obj->_layer);
+		_layerSizes.insert(_layerSizes.begin() + rank, 0);
+		for (auto& other : _objects)
+			if (other->_layerRank >= rank)
+				other->_layerRank++;
+		for (auto& other : _newObjects)
+			if (other != obj && other->_layerRank >= rank)
+				other->_layerRank++;
+	}
+	else if (_layerSizes[rank] == 0)
+		_emptyLayers--;
+
+	obj->_layerRank = rank;
+	_layerSizes[rank]++;
 }
 
-Objects Scene::objects(const RectF& cullingRect)
+void Scene::leaveLayer(Object* obj)
 {
-	Objects objectsInRect;
+	int rank = obj->_layerRank;
+	obj->_layerRank = -1;
+
+	// empty layers are kept until they are the majority, so that objects
+	// moving back and forth between layers do not cause rank updates
+	if (--_layerSizes[rank] == 0 && ++_emptyLayers > int(_layers.size()) / 2)
+		dropEmptyLayers();
+}
+
+void Scene::dropEmptyLayers()
+{
+	std::vector<int> newRanks(_layers.size());
+	int kept = 0;
+	for (size_t i = 0; i < _layers.size(); i++)
+	{
+		newRanks[i] = kept;
+		if (_layerSizes[i])
+		{
+			_layers[kept] = _layers[i];
+			_layerSizes[kept++] = _layerSizes[i];
+		}
+	}
+	_layers.resize(kept);
+	_layerSizes.resize(kept);
+	_emptyLayers = 0;
+
 	for (auto& obj : _objects)
-		if (obj->intersectsRectShallow(cullingRect))
-			objectsInRect.push_back(obj);
+		if (obj->_layerRank >= 0)
+			obj->_layerRank = newRanks[obj->_layerRank];
+	for (auto& obj : _newObjects)
+		if (obj->_layerRank >= 0)
+			obj->_layerRank = newRanks[obj->_layerRank];
+}
+
+Objects Scene::objects(const RectF& cullingRect, unsigned int categoryMask)
+{
+	Objects objectsInRect;
+	objects(cullingRect, objectsInRect, categoryMask);
 
 	return objectsInRect;
 }
 
+void Scene::objects(const RectF& cullingRect, Objects& result, unsigned int categoryMask)
+{
+	result.clear();
+	objects(cullingRect, [&result](Object* obj) { result.push_back(obj); return true; }, categoryMask);
+}
+
+void Scene::objects(const RectF& cullingRect, const ObjectVisitor& visitor, unsigned int categoryMask)
+{
+	for (auto& obj : _objects)
+		if ((obj->category() & categoryMask) && obj->intersectsRectShallow(cullingRect) && !visitor(obj))
+			return;
+}
+
 Objects Scene::objects(const PointF& containPoint)
 {
 	Objects objectsSelected;
-	for (auto& obj : _objects)
-		if (obj->contains(containPoint))
-			objectsSelected.push_back(obj);
+	objects(containPoint, objectsSelected);
 
 	return objectsSelected;
 }
 
-Objects Scene::raycast(const LineF& line, std::list<float>* hitTimes)
+void Scene::objects(const PointF& containPoint, Objects& result)
 {
-	std::vector<std::pair<Object*, float>> hits;
+	result.clear();
+	objects(containPoint, [&result](Object* obj) { result.push_back(obj); return true; });
+}
 
-	auto objectsInRect = objects(line.boundingRect(_rect.yUp));
-	for (Object* obj : objectsInRect)
-	{
-		float tNear;
-		if (obj->intersectsLine(line, tNear))
-			hits.push_back({ obj, tNear });
-	}
+void Scene::objects(const PointF& containPoint, const ObjectVisitor& visitor)
+{
+	for (auto& obj : _objects)
+		if (obj->contains(containPoint) && !visitor(obj))
+			return;
+}
 
-	// sort the hits based on the distance along the line (tNear):
-	std::sort(hits.begin(), hits.end(),
-		[](const std::pair<Object*, float>& a, const std::pair<Object*, float>& b) {
-			return a.second < b.second;
-		});
+Objects Scene::raycast(const LineF& line, std::list<float>* hitTimes)
+{
+	RaycastHits hits;
+	raycast(line, hits);
 
 	// extract the Object pointers from the sorted hits:
 	Objects result;
@@ -129,17 +233,72 @@ Objects Scene::raycast(const LineF& line, std::list<float>* hitTimes)
 	return result;
 }
 
-Object* Scene::raycastNearest(const LineF& line, float& tNear)
+void Scene::raycast(const LineF& line, RaycastHits& hits)
+{
+	hits.clear();
+
+	objects(line.boundingRect(_rect.yUp), [&](Object* obj)
+		{
+			float tNear;
+			if (obj->intersectsLine(line, tNear))
+				hits.push_back({ obj, tNear });
+			return true;
+		});
+
+	// sort the hits based on the distance along the line (tNear):
+	std::sort(hits.begin(), hits.end(),
+		[](const std::pair<Object*, float>& a, const std::pair<Object*, float>& b) {
+			return a.second < b.second;
+		});
+}
+
+Object* Scene::raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter)
+{
+	Object* nearest = nullptr;
+
+	objects(line.boundingRect(_rect.yUp), [&](Object* obj)
+		{
+			float t;
+			if (obj->intersectsLine(line, t) && (!nearest || t < tNear) && (!filter || filter(obj)))
+			{
+				nearest = obj;
+				tNear = t;
+			}
+			return true;
+		});
+
+	return nearest;
+}
+
+Objects Scene::nearestObjects(const PointF& point, int k, const ObjectFilter& filter, float maxDistance)
 {
-	std::list<float> hitTimes;
-	auto objects = raycast(line, &hitTimes);
-	if (objects.size())
+	std::vector<std::pair<float, Object*>> candidates;
+	for (auto& obj : _objects)
 	{
-		tNear = hitTimes.front();
-		return objects.front();
+		float distance = obj->rect().distance(point);
+		if (distance <= maxDistance && (!filter || filter(obj)))
+			candidates.push_back({ distance, obj });
 	}
-	else 
-		return nullptr;
+
+	// sort only the k nearest
+	size_t n = std::min(candidates.size(), size_t(std::max(k, 0)));
+	std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end());
+
+	Objects nearest;
+	for (size_t i = 0; i < n; i++)
+		nearest.push_back(candidates[i].second);
+
+	return nearest;
+}
+
+Objects Scene::objectsWithin(const PointF& point, float radius, const ObjectFilter& filter)
+{
+	Objects objectsSelected;
+	for (auto& obj : _objects)
+		if (obj->rect().distance(point) <= radius && (!filter || filter(obj)))
+			objectsSelected.push_back(obj);
+
+	return objectsSelected;
 }
 
 bool Scene::isEmpty(const RectF& rect)
@@ -151,6 +310,31 @@ bool Scene::isEmpty(const RectF& rect)
 	return true;
 }
 
+void Scene::intersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask)
+{
+	pairs.clear();
+
+	// sweep and prune along x
+	Objects candidates;
+	for (auto& obj : _objects)
+		if (obj->category() & categoryMask)
+			candidates.push_back(obj);
+	std::sort(candidates.begin(), candidates.end(),
+		[](const Object* a, const Object* b) { return a->rect().pos.x < b->rect().pos.x; });
+
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		Object* obj = candidates[i];
+		unsigned int otherMask = (obj->category() & activeMask) ? ALL_CATEGORIES : activeMask;
+		float right = obj->rect().pos.x + obj->rect().size.x;
+		for (size_t j = i + 1; j < candidates.size() && candidates[j]->rect().pos.x < right; j++)
+			if ((candidates[j]->category() & otherMask) && obj->rect().intersects(candidates[j]->rect()))
+				pairs.emplace_back(obj, candidates[j]);
+	}
+
+	SpatialIndex::sortPairs(pairs);
+}
+
 void Scene::render()
 {
 	if (_visible && _view)
@@ -161,23 +345,27 @@ void Scene::update(float timeToSimulate)
 {
 	refreshObjects();
 
-	auto iter = _schedulers.begin();
-	for (; iter != _schedulers.end(); )
-	{
-		if (iter->second.on())
-		{
-			iter->second.update(timeToSimulate);
-			++iter;
-		}
-		else
-			iter = _schedulers.erase(iter);
-	}
+	_sceneTimers.advance(timeToSimulate);
 }
 
 void Scene::schedule(const std::string& id, float delaySeconds, std::function<void()> action, int loop, bool overwrite)
 {
-	if (overwrite || _schedulers.find(id) == _schedulers.end())
-		_schedulers[id] = Scheduler(delaySeconds, action, loop);
+	schedule(TimerWheel::intern(id), delaySeconds, action, loop, overwrite);
+}
+
+void Scene::schedule(TimerId id, float delaySeconds, std::function<void()> action, int loop, bool overwrite)
+{
+	_sceneTimers.schedule(_timers, nullptr, id, delaySeconds, action, loop, overwrite);
+}
+
+void Scene::unschedule(const std::string& id)
+{
+	unschedule(TimerWheel::intern(id));
+}
+
+void Scene::unschedule(TimerId id)
+{
+	_sceneTimers.unschedule(_timers, id);
 }
 
 void Scene::event(SDL_Event& evt)
@@ -187,6 +375,27 @@ void Scene::event(SDL_Event& evt)
 }
 
 void Scene::objectMoved(Object* obj)
+{
+	// nothing to do here
+}
+
+void Scene::objectAdded(Object* obj)
+{
+	// nothing to do here
+}
+
+void Scene::objectRemoved(Object* obj)
+{
+	// nothing to do here
+}
+
+void Scene::objectLayerChanged(Object* obj)
+{
+	leaveLayer(obj);
+	joinLayer(obj);
+}
+
+void Scene::wakeObject(Object* obj)
 {
 	// nothing to do here
 }
\ No newline at end of file
@@ -9,12 +9,13 @@
 
 #pragma once
 #include <vector>
-#include <set>
 #include <list>
 #include <map>
 #include "geometryUtils.h"
 #include "graphicsUtils.h"
-#include "Scheduler.h"
+#include "TimerWheel.h"
+#include "SpatialIndex.h"
+#include "ObjectHandle.h"
 
 namespace agp
 {
@@ -24,7 +25,6 @@ namespace agp
 	class RenderableObject;
 
 	typedef std::vector< Object*> Objects;
-	typedef std::set< Object*> ObjectsSet;
 	typedef std::vector < RenderableObject*> Renderables;
 }
 
@@ -32,14 +32,26 @@ namespace agp
 // - provides base class for more specific scenes (e.g. GameScene, UIScene)
 //   with interface methods like rendering, logic update, and event processing
 // - provides simple container (std::vector) for scene objects with deferred add/remove
-// - provides global action scheduling
+// - deterministic update order: new objects are appended in spawn order, dead objects
+//   are removed in O(1) by moving the last object into their slot
+// - provides generational handles (see ObjectHandle) for long-lived object references
+// - keeps the layers in use sorted, so that objects know the rank of their layer and
+//   can be drawn in layer order by bucketing (see View::render) rather than sorting
+// - provides global action scheduling, and a timing wheel for the object timers
+//   (advanced by subclasses along with object updates)
 class agp::Scene
 {
 	protected:
 		
 		Objects _objects;
-		ObjectsSet _newObjects;		// new objects that need to be added
-		ObjectsSet _deadObjects;	// dead objects that need to be deallocated
+		Objects _newObjects;		// new objects that need to be added (spawn order, no duplicates)
+		Objects _deadObjects;		// dead objects, deallocated at the next refresh (kill order, no duplicates)
+		struct HandleSlot { Object* object; unsigned int generation; };
+		std::vector<HandleSlot> _handles;			// handle table (ObjectHandle::index = slot)
+		std::vector<unsigned int> _freeHandles;		// free slots of the handle table
+		std::vector<int> _layers;			// layers in use, ascending (Object::layerRank indexes it)
+		std::vector<int> _layerSizes;		// objects per layer
+		int _emptyLayers;					// layers with no objects, dropped in batches
 		RectF _rect;				// the scene (world) rectangle
 		Point _pixelUnitSize;		// unit size in pixels
 		Color _backgroundColor;		// background color
@@ -50,7 +62,14 @@ class agp::Scene
 		bool _blocking;				// whether blocks events propagation and logic update
 									// for scenes in lower layers of the stack
 		bool _rectsVisible;			// whether objects rects are visible
-		std::map<std::string, Scheduler> _schedulers;
+		TimerWheel _sceneTimers;	// scene actions, advanced in update()
+		TimerWheel::Timers _timers;	// pending scene actions
+		TimerWheel _objectTimers;	// object actions, advanced along with object updates
+
+		// layer ranks bookkeeping
+		void joinLayer(Object* obj);
+		void leaveLayer(Object* obj);
+		void dropEmptyLayers();
 
 	public:
 
@@ -80,14 +99,38 @@ class agp::Scene
 		virtual void killObject(Object* obj);
 		virtual void refreshObjects();
 
+		// layers in use (including a few empty ones), object layer ranks are in [0, layerCount)
+		int layerCount() const { return int(_layers.size()); }
+
+		// handle resolution, O(1): nullptr if the object has been deallocated
+		Object* object(const ObjectHandle& handle) const
+		{
+			return handle.index < _handles.size() && _handles[handle.index].generation == handle.generation ? _handles[handle.index].object : nullptr;
+		}
+
 		// geometric queries
-		virtual Objects objects();
-		virtual Objects objects(const RectF& cullingRect);
-		virtual Objects objects(const PointF& containPoint);
+		// - visitor overloads report objects one by one until the visitor returns false
+		//   (the visitor must not add/remove/move objects)
+		// - buffer overloads fill 'result' (no allocation if 'result' has enough capacity)
+		// - rect queries only report objects whose category matches the mask (see Object::category)
+		const Objects& objects() const { return _objects; }	// non-copying view
+		Objects objects(const RectF& cullingRect, unsigned int categoryMask = ALL_CATEGORIES);
+		void objects(const RectF& cullingRect, Objects& result, unsigned int categoryMask = ALL_CATEGORIES);
+		virtual void objects(const RectF& cullingRect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES);
+		Objects objects(const PointF& containPoint);
+		void objects(const PointF& containPoint, Objects& result);
+		virtual void objects(const PointF& containPoint, const ObjectVisitor& visitor);
 		virtual Objects raycast(const LineF& line, std::list<float> *hitTimes = nullptr);
-		virtual Object* raycastNearest(const LineF& line, float& tNear);
+		virtual void raycast(const LineF& line, RaycastHits& hits);	// sorted by hit time, no allocation if 'hits' has enough capacity
+		virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr);
+		virtual Objects nearestObjects(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity());
+		virtual Objects objectsWithin(const PointF& point, float radius, const ObjectFilter& filter = nullptr);
 		virtual bool isEmpty(const RectF& rect);
 
+		// broadphase: all pairs of intersecting objects matching categoryMask, at least one
+		// of the two matching activeMask, sorted by object ids (see SpatialIndex::queryIntersections)
+		virtual void intersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES);
+
 		// render
 		virtual void render();
 
@@ -96,10 +139,18 @@ class agp::Scene
 
 		// scheduling
 		virtual void schedule(const std::string& id, float delaySeconds, std::function<void()> action, int loop = 0, bool overwrite = true);
+		virtual void schedule(TimerId id, float delaySeconds, std::function<void()> action, int loop = 0, bool overwrite = true);
+		virtual void unschedule(const std::string& id);
+		virtual void unschedule(TimerId id);
+		TimerWheel& objectTimers() { return _objectTimers; }
 
 		// event handler
 		virtual void event(SDL_Event& evt);
 
 		// scene events
 		virtual void objectMoved(Object* obj);
+		virtual void objectAdded(Object* obj);		// at refresh, after the object joined the scene objects
+		virtual void objectRemoved(Object* obj);	// at refresh, right before the object is deallocated
+		virtual void objectLayerChanged(Object* obj);	// new layer of an object in the scene (spawning ones too)
+		virtual void wakeObject(Object* obj);		// the object needs update() again (e.g. new sprite), ignored if not in the scene objects
 };
\ No newline at end of file
@@ -0,0 +1,27 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+
+#include "SpatialIndex.h"
+#include "Object.h"
+
+using namespace agp;
+
+void SpatialIndex::sortPairs(ObjectPairs& pairs)
+{
+    for (auto& pair : pairs)
+        if (pair.second->id() < pair.first->id())
+            std::swap(pair.first, pair.second);
+
+    std::sort(pairs.begin(), pairs.end(),
+        [](const std::pair<Object*, Object*>& a, const std::pair<Object*, Object*>& b)
+        {
+            return a.first->id() != b.first->id() ? a.first->id() < b.first->id() : a.second->id() < b.second->id();
+        });
+}
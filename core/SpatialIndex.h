@@ -0,0 +1,169 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include "geometryUtils.h"
+
+namespace agp
+{
+    class Object;
+    class SpatialIndex;
+
+    typedef std::function<bool(Object*)> ObjectFilter;
+    typedef std::vector<std::pair<Object*, float>> RaycastHits;    // (object, hit time along the line)
+    typedef std::vector<std::pair<Object*, Object*>> ObjectPairs;  // (lower id object, higher id object)
+
+    // object category bitmasks (see Object::category)
+    const unsigned int DEFAULT_CATEGORY = 1;
+    const unsigned int ALL_CATEGORIES = 0xFFFFFFFF;
+
+    // non-owning reference to a bool(Object*) callable, returning false to stop the query
+    // - unlike std::function, it never allocates whatever the lambda captures
+    // - the callable must outlive the visitor (i.e. pass lambdas directly to queries)
+    class ObjectVisitor
+    {
+        private:
+
+            void* _callable;
+            bool (*_call)(void* callable, Object* obj);
+
+        public:
+
+            template <typename F, typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type, ObjectVisitor>::value &&
+                std::is_convertible<decltype(std::declval<F&>()(std::declval<Object*>())), bool>::value>::type>
+            ObjectVisitor(F&& f) :
+                _callable(const_cast<void*>(static_cast<const void*>(std::addressof(f)))),
+                _call([](void* callable, Object* obj) -> bool { return (*static_cast<typename std::remove_reference<F>::type*>(callable))(obj); }) {}
+
+            bool operator()(Object* obj) const { return _call(_callable, obj); }
+    };
+}
+
+// SpatialIndex abstract class
+// - common interface of the spatial partitioning structures used by game scenes
+//   (e.g. Quadtree, UniformGrid, AABBTree, LinearQuadtree)
+// - objects are added/removed/updated one by one, and retrieved by rect queries
+// - rect queries report objects to a visitor, so that callers can fill their own
+//   (reused) buffers or stop early without any allocation
+// - rect queries can be restricted to a category mask: only objects whose category
+//   shares at least one bit with the mask are reported
+// - the broadphase query reports all pairs of intersecting objects at once, split
+//   into independent tasks run in parallel on the ThreadPool
+// - objects not entirely contained in the index rect are ignored
+// - indices rebuilt from scratch (e.g. LinearQuadtree) do it in rebuild(), once per step
+// - raycasts visit the index along the line only; nearest queries stop
+//   as soon as no unvisited region can contain a closer hit
+// - nearest/radius queries use the distance from the point to the object rect
+class agp::SpatialIndex
+{
+    public:
+
+        virtual ~SpatialIndex() {}
+
+        virtual RectF rect() const = 0;
+
+        virtual void add(Object* obj) = 0;
+        virtual void remove(Object* obj) = 0;
+        virtual void update(Object* obj) = 0;
+        virtual void clear() = 0;
+
+        // adds many objects at once (e.g. at level load), by default one by one
+        virtual void bulkLoad(const std::vector<Object*>& objects) { for (auto obj : objects) add(obj); }
+
+        // called once per fixed step after all objects moved (no-op for incremental indices)
+        virtual void rebuild() {}
+
+        // rect queries
+        // - the visitor is called once per object intersecting the rect until it returns false
+        //   (it must not add/remove/update objects in the index)
+        // - objects are appended to 'objects' (no allocation if 'objects' has enough capacity)
+        virtual void queryObjects(const RectF& rect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) const = 0;
+        void queryObjects(const RectF& rect, std::vector<Object*>& objects, unsigned int categoryMask = ALL_CATEGORIES) const
+        {
+            queryObjects(rect, [&objects](Object* obj) { objects.push_back(obj); return true; }, categoryMask);
+        }
+        std::vector<Object*> queryObjects(const RectF& rect, unsigned int categoryMask = ALL_CATEGORIES) const
+        {
+            std::vector<Object*> objects;
+            queryObjects(rect, objects, categoryMask);
+            return objects;
+        }
+
+        // raycast: hit times are in [0,1] along the line
+        // - all hits are appended to 'hits' in no particular order (no allocation if 'hits' has enough capacity)
+        // - nearest hit among the objects accepted by the (optional) filter, nullptr if none
+        virtual void raycast(const LineF& line, RaycastHits& hits) const = 0;
+        virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) const = 0;
+
+        // proximity queries
+        // - k nearest objects (within maxDistance) accepted by the filter, sorted by increasing distance
+        // - objects within the given distance accepted by the filter, in no particular order
+        virtual std::vector<Object*> queryNearest(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) const = 0;
+        virtual std::vector<Object*> queryRadius(const PointF& point, float radius, const ObjectFilter& filter = nullptr) const = 0;
+
+        // broadphase: all pairs of intersecting objects, each reported once
+        // - only objects matching categoryMask, at least one of the two matching activeMask
+        //   (e.g. to skip pairs of static objects)
+        // - pairs are sorted by object ids, so results do not depend on traversal or threads order
+        virtual void queryIntersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const = 0;
+
+        // puts the lower id object first in each pair, then sorts pairs by ids
+        static void sortPairs(ObjectPairs& pairs);
+
+    protected:
+
+        // bounded max-heap of the k nearest candidates found so far
+        class NearestCandidates
+        {
+            private:
+
+                std::vector<std::pair<float, Object*>> _heap;     // (distance, object), farthest on top
+                std::size_t _k;
+                float _maxDistance;
+
+            public:
+
+                NearestCandidates(int k, float maxDistance) : _k(std::max(k, 0)), _maxDistance(maxDistance) { _heap.reserve(_k); }
+
+                // farthest distance a new candidate can have to be accepted
+                float bound() const { return _heap.size() < _k ? _maxDistance : _heap.front().first; }
+
+                void add(Object* obj, float distance, const ObjectFilter& filter)
+                {
+                    if (!_k || distance > bound() || (_heap.size() == _k && distance == bound()) || (filter && !filter(obj)))
+                        return;
+
+                    if (_heap.size() == _k)
+                    {
+                        std::pop_heap(_heap.begin(), _heap.end());
+                        _heap.pop_back();
+                    }
+                    _heap.emplace_back(distance, obj);
+                    std::push_heap(_heap.begin(), _heap.end());
+                }
+
+                std::vector<Object*> sorted()
+                {
+                    std::sort_heap(_heap.begin(), _heap.end());
+                    std::vector<Object*> objects;
+                    objects.reserve(_heap.size());
+                    for (const auto& candidate : _heap)
+                        objects.push_back(candidate.second);
+                    return objects;
+                }
+        };
+};
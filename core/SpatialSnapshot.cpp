@@ -0,0 +1,30 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SpatialSnapshot.h"
+#include "Object.h"
+
+using namespace agp;
+
+SpatialSnapshot::SpatialSnapshot(const RectF& rect) :
+    _tree(rect)
+{
+    _version = 0;
+}
+
+void SpatialSnapshot::build(const std::vector<Object*>& objects, unsigned int version)
+{
+    _entries.clear();
+    for (auto obj : objects)
+        _entries.push_back({ obj, obj->rect(), obj->category(), obj->id(), obj->denseId() });
+
+    _tree.clear();
+    _tree.bulkLoad(_entries);
+    _version = version;
+}
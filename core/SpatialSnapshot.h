@@ -0,0 +1,97 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "geometryUtils.h"
+#include "SpatialIndex.h"
+#include "BasicQuadtree.h"
+
+namespace agp
+{
+    class Object;
+    class SpatialSnapshot;
+}
+
+// Spatial snapshot class
+// - immutable copy of the scene objects at the end of a step, for queries run
+//   on other threads (AI, pathfinding, visibility) while the world keeps changing
+// - each entry copies the object rect, category and ids: queries never read live
+//   objects, so concurrent readers get consistent results for that step, lock-free
+// - object pointers are handles only (the object may be changed or deleted
+//   meanwhile): dereference them on the main thread
+// - a bulk-loaded BasicQuadtree of entries, rebuilt by build() (main thread only)
+// - const queries are safe from any number of threads (raycasts test the rects)
+class agp::SpatialSnapshot
+{
+    public:
+
+        struct Entry
+        {
+            Object* object;
+            RectF rect;
+            unsigned int category;
+            int id;
+            int denseId;
+        };
+        typedef std::vector<std::pair<Entry, float>> Hits;
+
+    private:
+
+        // Entry accessors used by the template
+        struct EntryTraits
+        {
+            static const RectF& rect(const Entry& e) { return e.rect; }
+            static int id(const Entry& e) { return e.id; }
+            static int denseId(const Entry& e) { return e.denseId; }
+            static unsigned int category(const Entry& e) { return e.category; }
+            static bool intersectsLine(const Entry& e, const LineF& line, float& tHit) { float tFar; return RectF(e.rect).intersectsLine(line.start, line.end, tHit, tFar); }
+        };
+
+        // attributes
+        BasicQuadtree<Entry, EntryTraits> _tree;
+        std::vector<Entry> _entries;    // build buffer, reused across builds
+        unsigned int _version;          // build counter of the owner (e.g. scene step)
+
+    public:
+
+        SpatialSnapshot(const RectF& rect);
+        RectF rect() const { return _tree.rect(); }
+        unsigned int version() const { return _version; }
+
+        // copies the given (alive) objects
+        void build(const std::vector<Object*>& objects, unsigned int version);
+
+        // same queries as SpatialIndex, reporting entries
+        template <typename Visitor>
+        void queryObjects(const RectF& rect, Visitor&& visitor, unsigned int categoryMask = ALL_CATEGORIES) const
+        {
+            _tree.queryObjects(rect, visitor, categoryMask);
+        }
+        void raycast(const LineF& line, Hits& hits) const { _tree.raycast(line, hits); }
+        template <typename Filter = BasicQuadtree<Entry, EntryTraits>::AcceptAll>
+        const Entry* raycastNearest(const LineF& line, float& tNear, Filter filter = Filter()) const
+        {
+            return _tree.raycastNearest(line, tNear, filter);
+        }
+        template <typename Filter = BasicQuadtree<Entry, EntryTraits>::AcceptAll>
+        std::vector<Entry> queryNearest(const PointF& point, int k, Filter filter = Filter(), float maxDistance = std::numeric_limits<float>::infinity()) const
+        {
+            return _tree.queryNearest(point, k, filter, maxDistance);
+        }
+        template <typename Filter = BasicQuadtree<Entry, EntryTraits>::AcceptAll>
+        std::vector<Entry> queryRadius(const PointF& point, float radius, Filter filter = Filter()) const
+        {
+            return _tree.queryRadius(point, radius, filter);
+        }
+
+        // debugging
+        std::size_t size() const { return _entries.size(); }
+};
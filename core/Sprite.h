@@ -10,6 +10,7 @@
 #pragma once
 #include "SDL.h"
 #include "geometryUtils.h"
+#include "ObjectPool.h"
 
 namespace agp
 {
@@ -18,7 +19,8 @@ namespace agp
 
 // Sprite
 // - base class for sprites that blit texture data directly from spritesheets
-class agp::Sprite
+// - pooled allocation (sprites are created with every spawned object)
+class agp::Sprite : public Pooled<Sprite>
 {
 	protected:
 
@@ -46,6 +48,10 @@ class agp::Sprite
 		// update method (for logic, animations)
 		virtual void update(float dt) {};
 
+		// true if update() changes the sprite over time (static objects with
+		// non-animated sprites are never updated, see GameScene)
+		virtual bool animated() const { return false; }
+
 		// reset method (for logic, animations)
 		virtual void reset() {};
 };
\ No newline at end of file
@@ -0,0 +1,389 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "StaticIndex.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <iostream>
+#include "Object.h"
+#include "ThreadPool.h"
+
+using namespace agp;
+
+StaticIndex::StaticIndex(const RectF& rect) :
+    _rect(rect)
+{
+    _dirty = false;
+}
+
+void StaticIndex::clear()
+{
+    _minX.clear();
+    _minY.clear();
+    _maxX.clear();
+    _maxY.clear();
+    _next.clear();
+    _categories.clear();
+    _objects.clear();
+    _pending.clear();
+    std::fill(_objectToNode.begin(), _objectToNode.end(), -1);
+    _dirty = false;
+}
+
+bool StaticIndex::contains(const Object* obj) const
+{
+    return obj->denseId() >= 0 && obj->denseId() < int(_objectToNode.size()) && _objectToNode[obj->denseId()] != -1;
+}
+
+void StaticIndex::add(Object* obj)
+{
+    if (!_rect.contains(obj->rect()))
+    {
+        if (VERBOSE)
+            std::cerr << strprintf("StaticIndex::add: index rect (%s) does not fully contain object (%s) rect (%s)", _rect.str().c_str(), obj->name().c_str(), obj->rect().str().c_str());
+        return;
+    }
+
+    if (obj->denseId() >= int(_objectToNode.size()))
+        _objectToNode.resize(std::max(std::size_t(obj->denseId() + 1), 2 * _objectToNode.size()), -1);
+
+    if (_objectToNode[obj->denseId()] != -1)
+    {
+        if (VERBOSE)
+            std::cerr << "StaticIndex::add: trying to add an object already present in the index\n";
+        return;
+    }
+
+    stage(obj);
+}
+
+void StaticIndex::remove(Object* obj)
+{
+    if (!contains(obj))
+        return;
+
+    int& node = _objectToNode[obj->denseId()];
+    if (node == PENDING)
+    {
+        auto it = std::find(_pending.begin(), _pending.end(), obj);
+        *it = _pending.back();
+        _pending.pop_back();
+    }
+    else
+        _objects[node] = nullptr;  // box and categories kept until the next build
+    node = -1;
+}
+
+void StaticIndex::update(Object* obj)
+{
+    if (!contains(obj))
+    {
+        if (VERBOSE)
+            std::cerr << "StaticIndex::update: trying to update an object [" << obj->name() << ", rect = " << obj->rect().str() << "] that is not present in the index\n";
+        return;
+    }
+
+    int node = _objectToNode[obj->denseId()];
+    RectF r = obj->rect();
+    if (node == PENDING || (_minX[node] == r.pos.x && _minY[node] == r.pos.y && _maxX[node] == r.pos.x + r.size.x &&
+        _maxY[node] == r.pos.y + r.size.y && _categories[node] == obj->category()))
+        return;
+
+    if (VERBOSE)
+        std::cerr << "StaticIndex::update: object [" << obj->name() << "] changed, the index will be rebuilt\n";
+
+    // the leaf is emptied and the object staged again
+    _objects[node] = nullptr;
+    if (_rect.contains(obj->rect()))
+        stage(obj);
+    else
+        _objectToNode[obj->denseId()] = -1;
+}
+
+void StaticIndex::stage(Object* obj)
+{
+    _pending.push_back(obj);
+    _objectToNode[obj->denseId()] = PENDING;
+    _dirty = true;
+}
+
+void StaticIndex::build()
+{
+    // stored (not removed) and staged objects
+    std::vector<Object*> objects;
+    objects.reserve(_objects.size() / 2 + 1 + _pending.size());
+    for (auto obj : _objects)
+        if (obj)
+            objects.push_back(obj);
+    objects.insert(objects.end(), _pending.begin(), _pending.end());
+    _pending.clear();
+    _dirty = false;
+
+    // a binary tree with one object per leaf has 2n-1 nodes
+    std::size_t nodes = objects.empty() ? 0 : 2 * objects.size() - 1;
+    for (auto v : { &_minX, &_minY, &_maxX, &_maxY })
+    {
+        v->clear();
+        v->reserve(nodes);
+    }
+    _next.clear();
+    _next.reserve(nodes);
+    _categories.clear();
+    _categories.reserve(nodes);
+    _objects.clear();
+    _objects.reserve(nodes);
+
+    if (!objects.empty())
+        build(objects, 0, int(objects.size()));
+}
+
+int StaticIndex::build(std::vector<Object*>& objects, int begin, int end)
+{
+    int node = int(_next.size());
+    _minX.push_back(0);
+    _minY.push_back(0);
+    _maxX.push_back(0);
+    _maxY.push_back(0);
+    _next.push_back(node + 1);
+    _categories.push_back(0);
+    _objects.push_back(nullptr);
+
+    if (end - begin == 1)
+    {
+        Object* obj = objects[begin];
+        RectF r = obj->rect();
+        _minX[node] = r.pos.x;
+        _minY[node] = r.pos.y;
+        _maxX[node] = r.pos.x + r.size.x;
+        _maxY[node] = r.pos.y + r.size.y;
+        _categories[node] = obj->category();
+        _objects[node] = obj;
+        _objectToNode[obj->denseId()] = node;
+        return node;
+    }
+
+    // split at the median of the centers along the longest axis of their bounds
+    PointF cMin(std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity());
+    PointF cMax(-cMin.x, -cMin.y);
+    for (int i = begin; i < end; i++)
+    {
+        PointF c = objects[i]->rect().center();
+        cMin = PointF(std::min(cMin.x, c.x), std::min(cMin.y, c.y));
+        cMax = PointF(std::max(cMax.x, c.x), std::max(cMax.y, c.y));
+    }
+    bool xAxis = cMax.x - cMin.x >= cMax.y - cMin.y;
+    int mid = (begin + end) / 2;
+    std::nth_element(objects.begin() + begin, objects.begin() + mid, objects.begin() + end,
+        [xAxis](Object* a, Object* b)
+        {
+            return xAxis ? a->rect().center().x < b->rect().center().x : a->rect().center().y < b->rect().center().y;
+        });
+
+    int left = build(objects, begin, mid);
+    int right = build(objects, mid, end);
+    _minX[node] = std::min(_minX[left], _minX[right]);
+    _minY[node] = std::min(_minY[left], _minY[right]);
+    _maxX[node] = std::max(_maxX[left], _maxX[right]);
+    _maxY[node] = std::max(_maxY[left], _maxY[right]);
+    _categories[node] = _categories[left] | _categories[right];
+    _next[node] = int(_next.size());
+    return node;
+}
+
+bool StaticIndex::overlaps(int node, const RectF& r) const
+{
+    return _minX[node] <= r.pos.x + r.size.x && _maxX[node] >= r.pos.x &&
+        _minY[node] <= r.pos.y + r.size.y && _maxY[node] >= r.pos.y;
+}
+
+void StaticIndex::queryObjects(const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const
+{
+    // stackless: enter the subtree (i+1) on overlap, skip it (next[i]) otherwise
+    int nodes = int(_next.size());
+    for (int i = 0; i < nodes; )
+    {
+        if (!(_categories[i] & categoryMask) || !overlaps(i, queryRect))
+        {
+            i = _next[i];
+            continue;
+        }
+
+        Object* obj = _objects[i];
+        if (obj && queryRect.intersects(obj->rect()) && !visitor(obj))
+            return;
+        i++;
+    }
+}
+
+void StaticIndex::raycast(const LineF& line, RaycastHits& hits) const
+{
+    int nodes = int(_next.size());
+    float tEnter, tExit;
+    for (int i = 0; i < nodes; )
+    {
+        if (!box(i).intersectsLine(line.start, line.end, tEnter, tExit))
+        {
+            i = _next[i];
+            continue;
+        }
+
+        float tHit;
+        Object* obj = _objects[i];
+        if (obj && obj->intersectsLine(line, tHit))
+            hits.emplace_back(obj, tHit);
+        i++;
+    }
+}
+
+Object* StaticIndex::raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter) const
+{
+    Object* nearest = nullptr;
+    float tBest = std::numeric_limits<float>::infinity();
+
+    // subtrees entered after the nearest hit found so far are skipped
+    int nodes = int(_next.size());
+    float tEnter, tExit;
+    for (int i = 0; i < nodes; )
+    {
+        if (!box(i).intersectsLine(line.start, line.end, tEnter, tExit) || tEnter >= tBest)
+        {
+            i = _next[i];
+            continue;
+        }
+
+        float tHit;
+        Object* obj = _objects[i];
+        if (obj && obj->intersectsLine(line, tHit) && tHit < tBest && (!filter || filter(obj)))
+        {
+            nearest = obj;
+            tBest = tHit;
+        }
+        i++;
+    }
+
+    if (nearest)
+        tNear = tBest;
+    return nearest;
+}
+
+std::vector<Object*> StaticIndex::queryNearest(const PointF& point, int k, const ObjectFilter& filter, float maxDistance) const
+{
+    NearestCandidates nearest(k, maxDistance);
+    if (k <= 0 || _next.empty())
+        return nearest.sorted();
+
+    // best-first: nodes are visited by increasing distance from the point,
+    // until the nearest unvisited node is farther than the k-th candidate
+    typedef std::pair<float, int> NodeDistance;
+    std::priority_queue<NodeDistance, std::vector<NodeDistance>, std::greater<NodeDistance>> frontier;
+    frontier.emplace(box(0).distance(point), 0);
+    while (!frontier.empty())
+    {
+        NodeDistance top = frontier.top();
+        frontier.pop();
+        if (top.first > nearest.bound())
+            break;
+
+        int node = top.second;
+        if (isLeaf(node))
+        {
+            if (_objects[node])
+                nearest.add(_objects[node], _objects[node]->rect().distance(point), filter);
+        }
+        else
+        {
+            for (int child : { node + 1, _next[node + 1] })
+            {
+                float distance = box(child).distance(point);
+                if (distance <= nearest.bound())
+                    frontier.emplace(distance, child);
+            }
+        }
+    }
+
+    return nearest.sorted();
+}
+
+std::vector<Object*> StaticIndex::queryRadius(const PointF& point, float radius, const ObjectFilter& filter) const
+{
+    auto objects = std::vector<Object*>();
+    int nodes = int(_next.size());
+    for (int i = 0; i < nodes; )
+    {
+        if (box(i).distance(point) > radius)
+        {
+            i = _next[i];
+            continue;
+        }
+
+        Object* obj = _objects[i];
+        if (obj && obj->rect().distance(point) <= radius && (!filter || filter(obj)))
+            objects.push_back(obj);
+        i++;
+    }
+
+    return objects;
+}
+
+void StaticIndex::queryIntersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    pairs.clear();
+
+    // no candidate pair at all (e.g. static vs. static pairs skipped)
+    if (_next.empty() || !(_categories[0] & categoryMask) || !(_categories[0] & activeMask))
+        return;
+
+    _leaves.clear();
+    for (int i = 0; i < int(_next.size()); i++)
+        if (_objects[i] && (_categories[i] & categoryMask))
+            _leaves.push_back(i);
+
+    // chunks of leaves are independent tasks, each filling its own buffer
+    int tasks = (int(_leaves.size()) + LEAVES_PER_TASK - 1) / LEAVES_PER_TASK;
+    if (_taskPairs.size() < std::size_t(tasks))
+        _taskPairs.resize(tasks);
+
+    ThreadPool::instance()->parallelFor(tasks, [&](int t)
+        {
+            _taskPairs[t].clear();
+            std::size_t end = std::min(_leaves.size(), std::size_t(t + 1) * LEAVES_PER_TASK);
+            for (std::size_t i = std::size_t(t) * LEAVES_PER_TASK; i < end; i++)
+                leafIntersections(_leaves[i], _taskPairs[t], categoryMask, activeMask);
+        });
+
+    for (int t = 0; t < tasks; t++)
+        pairs.insert(pairs.end(), _taskPairs[t].begin(), _taskPairs[t].end());
+    sortPairs(pairs);
+}
+
+void StaticIndex::leafIntersections(int leaf, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    Object* obj = _objects[leaf];
+    RectF leafRect = box(leaf);
+
+    // an inactive object only pairs with active ones
+    unsigned int otherMask = (obj->category() & activeMask) ? ALL_CATEGORIES : activeMask;
+
+    // each pair is found from both leaves, and kept from the lower id side
+    int nodes = int(_next.size());
+    for (int i = 0; i < nodes; )
+    {
+        if (!(_categories[i] & categoryMask) || !(_categories[i] & otherMask) || !overlaps(i, leafRect))
+        {
+            i = _next[i];
+            continue;
+        }
+
+        Object* other = _objects[i];
+        if (other && other->id() > obj->id() && obj->rect().intersects(other->rect()))
+            pairs.emplace_back(obj, other);
+        i++;
+    }
+}
@@ -0,0 +1,87 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "geometryUtils.h"
+#include "SpatialIndex.h"
+
+namespace agp
+{
+    class Object;
+    class StaticIndex;
+}
+
+// Static (read-only) index class
+// - container for game objects that never move after level load (terrain, walls, ...)
+// - objects are packed into a flat BVH built in one pass by build(): median splits
+//   along the longest axis, one object per leaf, leaf box = object rect
+// - nodes are stored depth-first as a structure of arrays: the left child of node i
+//   is i+1, and next[i] is the first node after the subtree of i (stackless traversal)
+// - add() and update() of a moved object only stage the change: queries see the
+//   objects of the last build() until the next one (see dirty())
+// - remove() is O(1): the leaf is emptied and dropped at the next build()
+// - object-to-leaf lookup is a flat table indexed by dense object id (see Object::denseId)
+class agp::StaticIndex : public SpatialIndex
+{
+    private:
+
+        // parameters
+        static constexpr int PENDING = -2;              // object-to-leaf value of staged objects
+        static constexpr int LEAVES_PER_TASK = 64;      // broadphase leaves processed by each parallel task
+        static constexpr bool VERBOSE = false;
+
+        // attributes
+        RectF _rect;
+        std::vector<float> _minX, _minY, _maxX, _maxY;  // node boxes
+        std::vector<int> _next;                         // first node after the subtree
+        std::vector<unsigned int> _categories;          // object category (leaves) or OR of the subtree categories
+        std::vector<Object*> _objects;                  // leaf object (nullptr = internal node or removed object)
+        std::vector<Object*> _pending;                  // objects staged for the next build
+        std::vector<int> _objectToNode;                 // indexed by dense object id (-1 = not stored)
+        bool _dirty;
+        mutable std::vector<int> _leaves;               // broadphase leaves, reused across queries
+        mutable std::vector<ObjectPairs> _taskPairs;    // one broadphase buffer per task, reused across queries
+
+        // helper functions
+        bool isLeaf(int node) const { return _next[node] == node + 1; }
+        RectF box(int node) const { return RectF(PointF(_minX[node], _minY[node]), PointF(_maxX[node], _maxY[node])); }
+        bool overlaps(int node, const RectF& r) const;
+        int build(std::vector<Object*>& objects, int begin, int end);
+        void stage(Object* obj);
+        void leafIntersections(int leaf, ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const;
+
+    public:
+
+        StaticIndex(const RectF& rect);
+        virtual RectF rect() const override { return _rect; }
+
+        // packs the stored and staged objects into a new BVH
+        void build();
+        virtual void rebuild() override { if (_dirty) build(); }
+        bool dirty() const { return _dirty; }
+        bool contains(const Object* obj) const;
+
+        virtual void add(Object* obj) override;
+        virtual void remove(Object* obj) override;
+        virtual void update(Object* obj) override;
+        virtual void clear() override;
+
+        using SpatialIndex::queryObjects;
+        virtual void queryObjects(const RectF& rect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) const override;
+        virtual void raycast(const LineF& line, RaycastHits& hits) const override;
+        virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) const override;
+        virtual std::vector<Object*> queryNearest(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) const override;
+        virtual std::vector<Object*> queryRadius(const PointF& point, float radius, const ObjectFilter& filter = nullptr) const override;
+        virtual void queryIntersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const override;
+
+        // debugging
+        int nodesCount() const { return int(_next.size()); }
+};
@@ -0,0 +1,100 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "ThreadPool.h"
+
+using namespace agp;
+
+// true while the current thread is running a task
+static thread_local bool insideTask = false;
+
+ThreadPool::ThreadPool()
+{
+	_task = nullptr;
+	_tasksCount = 0;
+	_nextTask = 0;
+	_busyWorkers = 0;
+	_loop = 0;
+	_quit = false;
+
+	// one worker per core, the calling thread being the last one
+	unsigned int cores = std::thread::hardware_concurrency();
+	for (unsigned int i = 1; i < cores; i++)
+		_workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wakeUp.notify_all();
+
+	for (auto& worker : _workers)
+		worker.join();
+}
+
+void ThreadPool::work()
+{
+	unsigned int loop = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wakeUp.wait(lock, [this, loop]() { return _quit || _loop != loop; });
+			if (_quit)
+				return;
+			loop = _loop;
+		}
+
+		runTasks();
+
+		// every worker goes through every loop, so the next loop
+		// cannot start before all workers are done with this one
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_busyWorkers == 0)
+			_done.notify_one();
+	}
+}
+
+void ThreadPool::runTasks()
+{
+	insideTask = true;
+	for (int i = _nextTask++; i < _tasksCount; i = _nextTask++)
+		(*_task)(i);
+	insideTask = false;
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task)
+{
+	// sequential: nothing to share, or nested call from a task
+	if (_workers.empty() || count <= 1 || insideTask)
+	{
+		for (int i = 0; i < count; i++)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_task = &task;
+		_tasksCount = count;
+		_nextTask = 0;
+		_busyWorkers = int(_workers.size());
+		_loop++;
+	}
+	_wakeUp.notify_all();
+
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this]() { return _busyWorkers == 0; });
+	_task = nullptr;
+}
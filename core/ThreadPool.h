@@ -0,0 +1,63 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include "Singleton.h"
+
+namespace agp
+{
+	class ThreadPool;
+}
+
+// ThreadPool (singleton)
+// - fixed set of worker threads, created once and reused by all parallel loops
+// - parallelFor runs count independent tasks and returns when all are done,
+//   the calling thread takes tasks as well
+// - nested parallelFor calls (from within a task) run sequentially
+// - parallelFor must be called by one thread at a time, and tasks must not throw
+class agp::ThreadPool : public Singleton<ThreadPool>
+{
+	friend class Singleton<ThreadPool>;
+
+	private:
+
+		std::vector<std::thread> _workers;
+		std::mutex _mutex;
+		std::condition_variable _wakeUp;		// new loop or quit
+		std::condition_variable _done;			// all workers left the current loop
+		const std::function<void(int)>* _task;	// current loop body (valid until parallelFor returns)
+		int _tasksCount;
+		std::atomic<int> _nextTask;
+		int _busyWorkers;						// workers still inside the current loop
+		unsigned int _loop;						// current loop counter, wakes up the workers
+		bool _quit;
+
+		void work();
+		void runTasks();
+
+	protected:
+
+		// constructor accessible only to Singleton (thanks to friend declaration)
+		ThreadPool();
+		virtual ~ThreadPool();
+
+	public:
+
+		// number of threads running tasks (workers + calling thread)
+		int threadsCount() const { return int(_workers.size()) + 1; }
+
+		// runs task(0), ..., task(count-1) in parallel, in no particular order
+		void parallelFor(int count, const std::function<void(int)>& task);
+};
@@ -0,0 +1,318 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "TimerWheel.h"
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include "Object.h"
+
+using namespace agp;
+
+TimerWheel::TimerWheel(float tick)
+{
+	if (tick <= 0)
+		throw "TimerWheel::TimerWheel: tick must be > 0";
+
+	for (auto& head : _lists)
+		head = NONE;
+	_now = 0;
+	_tick = tick;
+	_timeAccum = 0;
+	_firing = NONE;
+	_size = 0;
+}
+
+TimerId TimerWheel::intern(const std::string& name)
+{
+	static std::unordered_map<std::string, TimerId> ids;
+	auto iter = ids.find(name);
+	if (iter != ids.end())
+		return iter->second;
+
+	TimerId id = TimerId(ids.size());
+	ids[name] = id;
+	return id;
+}
+
+void TimerWheel::setTick(float tick)
+{
+	if (tick <= 0)
+		throw "TimerWheel::setTick: tick must be > 0";
+	if (_size)
+		throw "TimerWheel::setTick: cannot change tick with pending timers";
+
+	_tick = tick;
+	_timeAccum = 0;
+}
+
+void TimerWheel::link(int node, int list)
+{
+	Node& n = _nodes[node];
+	n.list = list;
+	n.prev = NONE;
+	n.next = _lists[list];
+	if (n.next != NONE)
+		_nodes[n.next].prev = node;
+	_lists[list] = node;
+}
+
+void TimerWheel::unlink(int node)
+{
+	Node& n = _nodes[node];
+	if (n.prev != NONE)
+		_nodes[n.prev].next = n.next;
+	else
+		_lists[n.list] = n.next;
+	if (n.next != NONE)
+		_nodes[n.next].prev = n.prev;
+	n.prev = n.next = n.list = NONE;
+}
+
+void TimerWheel::insert(int node)
+{
+	// level: smallest whose slots span the remaining ticks
+	unsigned long long delta = _nodes[node].expiry > _now ? _nodes[node].expiry - _now : 0;
+	int level = 0;
+	while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1))))
+		level++;
+
+	// beyond the wheel span: parked in the farthest slot, reinserted when reached
+	unsigned long long at = _nodes[node].expiry;
+	if (delta >= (1ull << (SLOT_BITS * LEVELS)))
+		at = _now + (1ull << (SLOT_BITS * LEVELS)) - 1;
+
+	link(node, level * SLOTS + int((at >> (SLOT_BITS * level)) & (SLOTS - 1)));
+}
+
+void TimerWheel::pause(int node, unsigned long long remaining)
+{
+	_nodes[node].remaining = remaining;
+	link(node, PAUSED);
+}
+
+void TimerWheel::forget(int node)
+{
+	Node& n = _nodes[node];
+	if (!n.timers)
+		return;
+
+	Timers& timers = *n.timers;
+	for (std::size_t i = 0; i < timers.size(); i++)
+		if (timers[i].second == node)
+		{
+			timers[i] = timers.back();
+			timers.pop_back();
+			break;
+		}
+	n.timers = nullptr;
+}
+
+void TimerWheel::release(int node)
+{
+	forget(node);
+
+	Node& n = _nodes[node];
+	n.action = nullptr;
+	n.owner = nullptr;
+	_freeNodes.push_back(node);
+	_size--;
+}
+
+void TimerWheel::cancel(int node)
+{
+	// the timer being fired is released once its action returns
+	// (its owner may be gone by then)
+	if (node == _firing)
+	{
+		_nodes[node].cancelled = true;
+		forget(node);
+		return;
+	}
+
+	unlink(node);
+	release(node);
+}
+
+void TimerWheel::schedule(Timers& timers, Object* owner, TimerId id, float delaySeconds, const std::function<void()>& action, int loop, bool overwrite)
+{
+	for (auto& timer : timers)
+		if (timer.first == id)
+		{
+			if (!overwrite)
+				return;
+			cancel(timer.second);
+			break;
+		}
+
+	int node;
+	if (_freeNodes.empty())
+	{
+		node = int(_nodes.size());
+		_nodes.emplace_back();
+	}
+	else
+	{
+		node = _freeNodes.back();
+		_freeNodes.pop_back();
+	}
+
+	// at least one tick: fires at the first tick at which delaySeconds have elapsed
+	Node& n = _nodes[node];
+	n.action = action;
+	n.delayTicks = std::max(1LL, (long long)(std::ceil(double(delaySeconds) / _tick - 1e-3)));
+	n.expiry = _now + n.delayTicks;
+	n.loop = loop;
+	n.id = id;
+	n.timers = &timers;
+	n.owner = owner;
+	n.cancelled = false;
+	if (running(owner))
+		insert(node);
+	else
+		pause(node, n.delayTicks);
+
+	timers.push_back({ id, node });
+	_size++;
+}
+
+void TimerWheel::unschedule(Timers& timers, TimerId id)
+{
+	for (auto& timer : timers)
+		if (timer.first == id)
+		{
+			cancel(timer.second);
+			return;
+		}
+}
+
+void TimerWheel::unscheduleAll(Timers& timers)
+{
+	while (!timers.empty())
+		cancel(timers.back().second);
+}
+
+bool TimerWheel::scheduled(const Timers& timers, TimerId id)
+{
+	for (auto& timer : timers)
+		if (timer.first == id)
+			return true;
+	return false;
+}
+
+bool TimerWheel::running(const Object* owner)
+{
+	return !owner || (!owner->freezed() && owner->updateMode() != Object::UPDATE_FROZEN);
+}
+
+void TimerWheel::setPaused(Timers& timers, bool paused)
+{
+	for (auto& timer : timers)
+	{
+		int node = timer.second;
+		Node& n = _nodes[node];
+
+		// the timer being fired is not in any list: paused, if needed, when re-armed
+		if (paused && n.list != PAUSED && n.list != NONE)
+		{
+			unsigned long long remaining = n.expiry > _now ? n.expiry - _now : 0;
+			unlink(node);
+			pause(node, remaining);
+		}
+		else if (!paused && n.list == PAUSED)
+		{
+			unlink(node);
+			n.expiry = _now + std::max(1ULL, n.remaining);
+			insert(node);
+		}
+	}
+}
+
+void TimerWheel::cascade(int level)
+{
+	int list = level * SLOTS + int((_now >> (SLOT_BITS * level)) & (SLOTS - 1));
+	while (_lists[list] != NONE)
+	{
+		int node = _lists[list];
+		unlink(node);
+		insert(node);
+	}
+}
+
+void TimerWheel::step()
+{
+	_now++;
+
+	// higher level slots whose turn has come are redistributed (highest first)
+	int level = 0;
+	while (level < LEVELS - 1 && (_now & ((1ull << (SLOT_BITS * (level + 1))) - 1)) == 0)
+		level++;
+	for (; level > 0; level--)
+		cascade(level);
+
+	// the due slot is moved to the firing list, since actions may (un)schedule timers
+	int due = int(_now & (SLOTS - 1));
+	while (_lists[due] != NONE)
+	{
+		int node = _lists[due];
+		unlink(node);
+		link(node, FIRING);
+	}
+
+	while (_lists[FIRING] != NONE)
+	{
+		int node = _lists[FIRING];
+		unlink(node);
+
+		// parked beyond the wheel span
+		if (_nodes[node].expiry > _now)
+		{
+			insert(node);
+			continue;
+		}
+
+		// owner stopped running without pausing its timers: fires at resume
+		if (!running(_nodes[node].owner))
+		{
+			pause(node, 0);
+			continue;
+		}
+
+		// the action is moved out of the node: nodes may be reallocated meanwhile
+		std::function<void()> action = std::move(_nodes[node].action);
+		_firing = node;
+		action();
+		_firing = NONE;
+
+		Node& n = _nodes[node];
+		if (!n.cancelled && n.loop != 0)
+		{
+			n.action = std::move(action);
+			n.expiry = _now + n.delayTicks;
+			n.loop--;
+			if (running(n.owner))
+				insert(node);
+			else
+				pause(node, n.delayTicks);
+		}
+		else
+			release(node);
+	}
+}
+
+void TimerWheel::advance(float dt)
+{
+	// tolerance: a dt equal to the tick is always one tick, despite rounding
+	_timeAccum += dt;
+	while (_timeAccum >= _tick * 0.999f)
+	{
+		_timeAccum -= _tick;
+		step();
+	}
+}
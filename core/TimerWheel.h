@@ -0,0 +1,113 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace agp
+{
+	class Object;
+	class TimerWheel;
+
+	// interned timer name (see TimerWheel::intern)
+	typedef int TimerId;
+}
+
+// TimerWheel class
+// - hierarchical timing wheel: LEVELS levels of SLOTS slots, level l slots span
+//   SLOTS^l ticks; timers are cascaded to lower levels as their expiry approaches
+// - O(1) schedule, cancel and fire; a tick only visits the timers due at that tick
+//   (plus those cascaded), so owners without timers cost nothing
+// - timers belong to an owner (an object, or the scene itself) and are identified by
+//   interned ids: each owner keeps the list of its own timers (at most one per id)
+// - timer actions may schedule or cancel any timer (including their own)
+// - timers of freezed or sleeping (see Object::UPDATE_FROZEN) objects are paused: they
+//   leave the wheel with their remaining ticks, and are re-armed once the object runs
+//   again (see setPaused), so that sleeping objects cost nothing per tick
+class agp::TimerWheel
+{
+	public:
+
+		// timers of an owner (id -> node)
+		typedef std::vector<std::pair<TimerId, int>> Timers;
+
+	private:
+
+		// parameters
+		static constexpr int SLOT_BITS = 6;
+		static constexpr int SLOTS = 1 << SLOT_BITS;
+		static constexpr int LEVELS = 4;				// 2^24 ticks (~3 days at 60 Hz)
+		static constexpr int FIRING = LEVELS * SLOTS;	// list of the timers being fired
+		static constexpr int PAUSED = FIRING + 1;		// list of the timers of owners not running
+		static constexpr int NONE = -1;
+
+		struct Node
+		{
+			std::function<void()> action;
+			unsigned long long expiry;		// tick
+			unsigned long long remaining;	// ticks left, while paused
+			long long delayTicks;			// for loops
+			int loop;						// -1 = infinite loop
+			TimerId id;
+			Timers* timers;					// owner timers
+			Object* owner;					// nullptr = not an object
+			int prev, next;					// doubly-linked list of the slot
+			int list;						// slot (level * SLOTS + slot), or FIRING
+			bool cancelled;					// while firing
+		};
+
+		// attributes
+		std::vector<Node> _nodes;
+		std::vector<int> _freeNodes;
+		int _lists[LEVELS * SLOTS + 2];		// list heads
+		unsigned long long _now;			// ticks elapsed
+		float _tick;						// tick duration (seconds)
+		float _timeAccum;					// time not yet ticked
+		int _firing;						// timer whose action is running
+		int _size;
+
+		// helper functions
+		void link(int node, int list);
+		void unlink(int node);
+		void insert(int node);
+		void forget(int node);		// removes the timer from its owner timers
+		void release(int node);
+		void cancel(int node);
+		void pause(int node, unsigned long long remaining);
+		void cascade(int level);
+		void step();
+
+	public:
+
+		TimerWheel(float tick = 1 / 60.0f);
+
+		// interned id of the given name, shared by all wheels
+		static TimerId intern(const std::string& name);
+
+		float tick() const { return _tick; }
+		void setTick(float tick);				// only while no timer is pending
+		int size() const { return _size; }		// pending timers
+
+		// timers of an owner: action after delaySeconds (rounded up to ticks, at least one),
+		// repeated 'loop' more times, -1 = forever), overwrite = false keeps a pending timer
+		void schedule(Timers& timers, Object* owner, TimerId id, float delaySeconds, const std::function<void()>& action, int loop = 0, bool overwrite = true);
+		void unschedule(Timers& timers, TimerId id);
+		void unscheduleAll(Timers& timers);
+		static bool scheduled(const Timers& timers, TimerId id);
+
+		// whether the timers of the given owner count down (objects must call setPaused
+		// whenever this changes), paused timers resume with the ticks they had left
+		static bool running(const Object* owner);
+		void setPaused(Timers& timers, bool paused);
+
+		// fires the timers due in the next dt seconds
+		void advance(float dt);
+};
@@ -24,6 +24,9 @@ void UIScene::update(float timeToSimulate)
 	Scene::update(timeToSimulate);
 
 	if (_active)
+	{
 		for (auto& obj : _objects)
 			obj->update(timeToSimulate);
+		_objectTimers.advance(timeToSimulate);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,410 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "UniformGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include "Object.h"
+#include "ThreadPool.h"
+
+using namespace agp;
+
+UniformGrid::UniformGrid(const RectF& rect, const PointF& cellSize) :
+    _rect(rect)
+{
+    if (cellSize.x <= 0 || cellSize.y <= 0)
+        throw "UniformGrid::UniformGrid: cell size must be > 0";
+
+    _cellSize = cellSize;
+    _cols = std::max(1, int(std::ceil(_rect.size.x / _cellSize.x)));
+    _rows = std::max(1, int(std::ceil(_rect.size.y / _cellSize.y)));
+    _cells.resize(std::size_t(_cols) * _rows);
+    _queryStamp = 0;
+}
+
+PointF UniformGrid::cellSizeFromPixelUnitSize(const Point& pixelUnitSize)
+{
+    // cells of (at least) CELL_PIXELS x CELL_PIXELS, aligned to scene units (tiles)
+    return PointF(
+        std::max(1.0f, std::round(float(CELL_PIXELS) / std::max(1, pixelUnitSize.x))),
+        std::max(1.0f, std::round(float(CELL_PIXELS) / std::max(1, pixelUnitSize.y))));
+}
+
+void UniformGrid::clear()
+{
+    for (auto& cell : _cells)
+        cell.clear();
+    std::fill(_objectToCells.begin(), _objectToCells.end(), CellRange());
+}
+
+void UniformGrid::add(Object* obj)
+{
+    if (!_rect.contains(obj->rect()))
+    {
+        if (VERBOSE)
+            std::cerr << strprintf("UniformGrid::add: grid rect (%s) does not fully contain object (%s) rect (%s)", _rect.str().c_str(), obj->name().c_str(), obj->rect().str().c_str());
+        return;
+    }
+
+    if (obj->denseId() >= int(_objectToCells.size()))
+        _objectToCells.resize(std::max(std::size_t(obj->denseId() + 1), 2 * _objectToCells.size()));
+
+    CellRange& range = _objectToCells[obj->denseId()];
+    if (!range.empty())
+    {
+        if (VERBOSE)
+            std::cerr << "UniformGrid::add: trying to add an object already present in the grid\n";
+        return;
+    }
+
+    range = cellRange(obj->rect());
+    cellsAdd(range, obj);
+}
+
+void UniformGrid::remove(Object* obj)
+{
+    CellRange* range = entry(obj);
+    if (!range || range->empty())
+        return;
+
+    cellsRemove(*range, obj);
+    *range = CellRange();
+}
+
+void UniformGrid::update(Object* obj)
+{
+    CellRange* range = entry(obj);
+    if (!range || range->empty())
+    {
+        if (VERBOSE)
+            std::cerr << "UniformGrid::update: trying to update an object [" << obj->name() << ", rect = " << obj->rect().str() << "] that is not present in the grid\n";
+        return;
+    }
+
+    if (!_rect.contains(obj->rect()))
+    {
+        remove(obj);
+        return;
+    }
+
+    // fast path: the object still covers the same cells
+    CellRange newRange = cellRange(obj->rect());
+    if (newRange == *range)
+        return;
+
+    cellsRemove(*range, obj);
+    cellsAdd(newRange, obj);
+    *range = newRange;
+}
+
+void UniformGrid::queryObjects(const RectF& queryRect, const ObjectVisitor& visitor, unsigned int categoryMask) const
+{
+    if (!queryRect.intersects(_rect))
+        return;
+
+    // objects spanning multiple cells are reported only once
+    nextQueryStamp();
+
+    CellRange range = cellRange(queryRect);
+    for (int y = range.y0; y <= range.y1; y++)
+        for (int x = range.x0; x <= range.x1; x++)
+            for (auto obj : _cells[std::size_t(y) * _cols + x])
+            {
+                if (!(obj->category() & categoryMask))
+                    continue;
+
+                unsigned int& stamp = _queryStamps[obj->denseId()];
+                if (stamp != _queryStamp)
+                {
+                    stamp = _queryStamp;
+                    if (queryRect.intersects(obj->rect()) && !visitor(obj))
+                        return;
+                }
+            }
+}
+
+void UniformGrid::queryIntersections(ObjectPairs& pairs, unsigned int categoryMask, unsigned int activeMask) const
+{
+    pairs.clear();
+
+    // rows are independent tasks, each filling its own buffer
+    // (no query stamps here: duplicates are avoided by the first common cell rule)
+    if (_rowPairs.size() < std::size_t(_rows))
+        _rowPairs.resize(_rows);
+
+    ThreadPool::instance()->parallelFor(_rows, [&](int y)
+        {
+            ObjectPairs& rowPairs = _rowPairs[y];
+            rowPairs.clear();
+            for (int x = 0; x < _cols; x++)
+            {
+                const auto& cell = _cells[std::size_t(y) * _cols + x];
+                for (std::size_t i = 0; i < cell.size(); i++)
+                {
+                    Object* a = cell[i];
+                    if (!(a->category() & categoryMask))
+                        continue;
+
+                    // an inactive object only pairs with active ones
+                    unsigned int otherMask = (a->category() & activeMask) ? ALL_CATEGORIES : activeMask;
+                    const CellRange& ra = _objectToCells[a->denseId()];
+                    for (std::size_t j = i + 1; j < cell.size(); j++)
+                    {
+                        Object* b = cell[j];
+                        if (!(b->category() & categoryMask) || !(b->category() & otherMask))
+                            continue;
+
+                        // the first cell shared by both ranges reports the pair
+                        const CellRange& rb = _objectToCells[b->denseId()];
+                        if (std::max(ra.x0, rb.x0) == x && std::max(ra.y0, rb.y0) == y && a->rect().intersects(b->rect()))
+                            rowPairs.emplace_back(a, b);
+                    }
+                }
+            }
+        });
+
+    for (int y = 0; y < _rows; y++)
+        pairs.insert(pairs.end(), _rowPairs[y].begin(), _rowPairs[y].end());
+    sortPairs(pairs);
+}
+
+void UniformGrid::raycast(const LineF& line, RaycastHits& hits) const
+{
+    nextQueryStamp();
+
+    traverse(line, [&](int cell, float /*tCellExit*/)
+        {
+            float tHit;
+            for (auto obj : _cells[cell])
+            {
+                unsigned int& stamp = _queryStamps[obj->denseId()];
+                if (stamp != _queryStamp)
+                {
+                    stamp = _queryStamp;
+                    if (obj->intersectsLine(line, tHit))
+                        hits.emplace_back(obj, tHit);
+                }
+            }
+            return true;
+        });
+}
+
+Object* UniformGrid::raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter) const
+{
+    nextQueryStamp();
+
+    Object* nearest = nullptr;
+    float tBest = std::numeric_limits<float>::infinity();
+    traverse(line, [&](int cell, float tCellExit)
+        {
+            float tHit;
+            for (auto obj : _cells[cell])
+            {
+                unsigned int& stamp = _queryStamps[obj->denseId()];
+                if (stamp != _queryStamp)
+                {
+                    stamp = _queryStamp;
+                    if (obj->intersectsLine(line, tHit) && tHit < tBest && (!filter || filter(obj)))
+                    {
+                        nearest = obj;
+                        tBest = tHit;
+                    }
+                }
+            }
+
+            // next cells are entered after this one is exited: cannot contain a closer hit
+            return tBest > tCellExit;
+        });
+
+    if (nearest)
+        tNear = tBest;
+    return nearest;
+}
+
+std::vector<Object*> UniformGrid::queryNearest(const PointF& point, int k, const ObjectFilter& filter, float maxDistance) const
+{
+    NearestCandidates nearest(k, maxDistance);
+    if (k <= 0)
+        return nearest.sorted();
+
+    nextQueryStamp();
+
+    // cell containing the point (or the nearest border cell)
+    int cx = std::min(std::max(int(std::floor((point.x - _rect.pos.x) / _cellSize.x)), 0), _cols - 1);
+    int cy = std::min(std::max(int(std::floor((point.y - _rect.pos.y) / _cellSize.y)), 0), _rows - 1);
+
+    float minCellSize = std::min(_cellSize.x, _cellSize.y);
+    int maxRing = std::max(std::max(cx, _cols - 1 - cx), std::max(cy, _rows - 1 - cy));
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        // cells in this ring are at least (ring - 1) cells away from the point
+        if (ring > 0 && (ring - 1) * minCellSize > nearest.bound())
+            break;
+
+        for (int y = cy - ring; y <= cy + ring; y++)
+        {
+            if (y < 0 || y >= _rows)
+                continue;
+
+            // inner rows: only the first and the last cell belong to the ring
+            int xStep = (y == cy - ring || y == cy + ring) ? 1 : 2 * ring;
+            for (int x = cx - ring; x <= cx + ring; x += xStep)
+            {
+                if (x < 0 || x >= _cols)
+                    continue;
+
+                for (auto obj : _cells[std::size_t(y) * _cols + x])
+                {
+                    unsigned int& stamp = _queryStamps[obj->denseId()];
+                    if (stamp != _queryStamp)
+                    {
+                        stamp = _queryStamp;
+                        nearest.add(obj, obj->rect().distance(point), filter);
+                    }
+                }
+            }
+        }
+    }
+
+    return nearest.sorted();
+}
+
+std::vector<Object*> UniformGrid::queryRadius(const PointF& point, float radius, const ObjectFilter& filter) const
+{
+    auto objects = std::vector<Object*>();
+    if (_rect.distance(point) > radius)
+        return objects;
+
+    nextQueryStamp();
+
+    CellRange range = cellRange(RectF(point.x - radius, point.y - radius, 2 * radius, 2 * radius, _rect.yUp));
+    for (int y = range.y0; y <= range.y1; y++)
+        for (int x = range.x0; x <= range.x1; x++)
+            for (auto obj : _cells[std::size_t(y) * _cols + x])
+            {
+                unsigned int& stamp = _queryStamps[obj->denseId()];
+                if (stamp != _queryStamp)
+                {
+                    stamp = _queryStamp;
+                    if (obj->rect().distance(point) <= radius && (!filter || filter(obj)))
+                        objects.push_back(obj);
+                }
+            }
+
+    return objects;
+}
+
+template <typename Visitor>
+void UniformGrid::traverse(const LineF& line, Visitor visit) const
+{
+    // clip the line against the grid
+    float tEnter, tExit;
+    if (!RectF(_rect).intersectsLine(line.start, line.end, tEnter, tExit))
+        return;
+
+    // start cell
+    PointF dir = line.end - line.start;
+    PointF p = line.start + dir * tEnter;
+    int x = std::min(std::max(int(std::floor((p.x - _rect.pos.x) / _cellSize.x)), 0), _cols - 1);
+    int y = std::min(std::max(int(std::floor((p.y - _rect.pos.y) / _cellSize.y)), 0), _rows - 1);
+
+    // line parameter increments per cell, and at the next cell border along each axis
+    const float inf = std::numeric_limits<float>::infinity();
+    int stepX = dir.x > 0 ? 1 : (dir.x < 0 ? -1 : 0);
+    int stepY = dir.y > 0 ? 1 : (dir.y < 0 ? -1 : 0);
+    float tDeltaX = stepX ? _cellSize.x / std::abs(dir.x) : inf;
+    float tDeltaY = stepY ? _cellSize.y / std::abs(dir.y) : inf;
+    float tMaxX = stepX ? (_rect.pos.x + (x + (stepX > 0 ? 1 : 0)) * _cellSize.x - line.start.x) / dir.x : inf;
+    float tMaxY = stepY ? (_rect.pos.y + (y + (stepY > 0 ? 1 : 0)) * _cellSize.y - line.start.y) / dir.y : inf;
+
+    // visit cells in order until the visitor stops or the line ends
+    while (true)
+    {
+        float tCellExit = std::min(std::min(tMaxX, tMaxY), tExit);
+        if (!visit(y * _cols + x, tCellExit) || tCellExit >= tExit)
+            return;
+
+        if (tMaxX < tMaxY)
+        {
+            x += stepX;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            y += stepY;
+            tMaxY += tDeltaY;
+        }
+        if (x < 0 || x >= _cols || y < 0 || y >= _rows)
+            return;
+    }
+}
+
+void UniformGrid::nextQueryStamp() const
+{
+    if (++_queryStamp == 0)
+    {
+        std::fill(_queryStamps.begin(), _queryStamps.end(), 0);
+        _queryStamp = 1;
+    }
+    if (_queryStamps.size() < _objectToCells.size())
+        _queryStamps.resize(_objectToCells.size(), 0);
+}
+
+UniformGrid::CellRange UniformGrid::cellRange(const RectF& r) const
+{
+    // rect pos is always the min corner, regardless of yUp
+    // (a rect ending exactly on a cell border does not cover the next cell)
+    CellRange range;
+    range.x0 = int(std::floor((r.pos.x - _rect.pos.x) / _cellSize.x));
+    range.y0 = int(std::floor((r.pos.y - _rect.pos.y) / _cellSize.y));
+    range.x1 = std::max(range.x0, int(std::ceil((r.pos.x + r.size.x - _rect.pos.x) / _cellSize.x)) - 1);
+    range.y1 = std::max(range.y0, int(std::ceil((r.pos.y + r.size.y - _rect.pos.y) / _cellSize.y)) - 1);
+
+    range.x0 = std::min(std::max(range.x0, 0), _cols - 1);
+    range.y0 = std::min(std::max(range.y0, 0), _rows - 1);
+    range.x1 = std::min(std::max(range.x1, 0), _cols - 1);
+    range.y1 = std::min(std::max(range.y1, 0), _rows - 1);
+
+    return range;
+}
+
+void UniformGrid::cellsAdd(const CellRange& range, Object* obj)
+{
+    for (int y = range.y0; y <= range.y1; y++)
+        for (int x = range.x0; x <= range.x1; x++)
+            _cells[std::size_t(y) * _cols + x].push_back(obj);
+}
+
+void UniformGrid::cellsRemove(const CellRange& range, Object* obj)
+{
+    for (int y = range.y0; y <= range.y1; y++)
+        for (int x = range.x0; x <= range.x1; x++)
+        {
+            // cells are small: linear search, then swap with the last element and pop back
+            auto& cell = _cells[std::size_t(y) * _cols + x];
+            auto it = std::find(cell.begin(), cell.end(), obj);
+            if (it != cell.end())
+            {
+                *it = cell.back();
+                cell.pop_back();
+            }
+            else if (VERBOSE)
+                std::cerr << "UniformGrid::cellsRemove: trying to remove an object that is not present in the cell\n";
+        }
+}
+
+UniformGrid::CellRange* UniformGrid::entry(const Object* obj)
+{
+    if (obj->denseId() < 0 || obj->denseId() >= int(_objectToCells.size()))
+        return nullptr;
+
+    return &_objectToCells[obj->denseId()];
+}
@@ -0,0 +1,96 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+
+#pragma once
+
+#include <vector>
+#include "geometryUtils.h"
+#include "SpatialIndex.h"
+
+namespace agp
+{
+    class Object;
+    class UniformGrid;
+}
+
+// Uniform grid (or dense spatial hash) class
+// - container for game objects stored according to spatial partitioning
+// - the index rect is split into equally sized cells, each object is stored in
+//   all the cells its rect overlaps
+// - add/remove/update/query cost is proportional to the number of cells covered
+//   (O(1) for objects/queries smaller than a cell), regardless of the objects count
+// - update() is O(1) when the object still covers the same cells
+// - raycasts walk the cells crossed by the line in order (Amanatides-Woo traversal)
+// - k-nearest queries visit rings of cells around the query point
+// - broadphase tests pairs within each cell, rows of cells in parallel: a pair sharing
+//   several cells is reported by the first one only
+// - best suited for tile-aligned worlds with evenly distributed objects
+// - object-to-cells lookup is a flat table indexed by dense object id (see Object::denseId)
+class agp::UniformGrid : public SpatialIndex
+{
+    private:
+
+        // parameters
+        static constexpr int CELL_PIXELS = 64;      // default cell size in pixels
+        static constexpr bool VERBOSE = false;
+
+        // inner classes/structs
+        struct CellRange
+        {
+            int x0 = 0, y0 = 0;     // first cell (inclusive)
+            int x1 = -1, y1 = -1;   // last cell (inclusive), empty range = not stored
+            bool empty() const { return x1 < x0 || y1 < y0; }
+            bool operator == (const CellRange& r) const { return x0 == r.x0 && y0 == r.y0 && x1 == r.x1 && y1 == r.y1; }
+        };
+
+        // attributes
+        RectF _rect;
+        PointF _cellSize;
+        int _cols, _rows;
+        std::vector<std::vector<Object*>> _cells;   // row-major
+        std::vector<CellRange> _objectToCells;      // indexed by dense object id
+        mutable std::vector<unsigned int> _queryStamps; // indexed by dense object id, avoids duplicates in query results
+        mutable unsigned int _queryStamp;
+        mutable std::vector<ObjectPairs> _rowPairs;    // one broadphase buffer per row, reused across queries
+
+        // helper functions
+        CellRange cellRange(const RectF& r) const;
+        void cellsAdd(const CellRange& range, Object* obj);
+        void cellsRemove(const CellRange& range, Object* obj);
+        CellRange* entry(const Object* obj);
+        void nextQueryStamp() const;
+        template <typename Visitor>
+        void traverse(const LineF& line, Visitor visit) const;
+
+    public:
+
+        UniformGrid(const RectF& rect, const PointF& cellSize);
+        virtual RectF rect() const override { return _rect; }
+        PointF cellSize() const { return _cellSize; }
+
+        // default cell size (in scene units) for the given scene unit size (in pixels)
+        static PointF cellSizeFromPixelUnitSize(const Point& pixelUnitSize);
+
+        virtual void add(Object* obj) override;
+        virtual void remove(Object* obj) override;
+        virtual void update(Object* obj) override;
+        virtual void clear() override;
+
+        using SpatialIndex::queryObjects;
+        virtual void queryObjects(const RectF& rect, const ObjectVisitor& visitor, unsigned int categoryMask = ALL_CATEGORIES) const override;
+        virtual void raycast(const LineF& line, RaycastHits& hits) const override;
+        virtual Object* raycastNearest(const LineF& line, float& tNear, const ObjectFilter& filter = nullptr) const override;
+        virtual std::vector<Object*> queryNearest(const PointF& point, int k, const ObjectFilter& filter = nullptr, float maxDistance = std::numeric_limits<float>::infinity()) const override;
+        virtual std::vector<Object*> queryRadius(const PointF& point, float radius, const ObjectFilter& filter = nullptr) const override;
+        virtual void queryIntersections(ObjectPairs& pairs, unsigned int categoryMask = ALL_CATEGORIES, unsigned int activeMask = ALL_CATEGORIES) const override;
+
+        // debugging
+        int cellsCount() const { return _cols * _rows; }
+};
@@ -7,6 +7,7 @@
 // See LICENSE in root directory for full details.
 // ----------------------------------------------------------------
 
+#include <cassert>
 #include "SDL.h"
 #include "View.h"
 #include "Window.h"
@@ -83,20 +84,30 @@ void View::render()
 	SDL_SetRenderDrawColor(renderer, _scene->backgroundColor().r, _scene->backgroundColor().g, _scene->backgroundColor().b, _scene->backgroundColor().a);
 	SDL_RenderFillRect(renderer, &viewport_r);
 
-	// sort visible objects by z
+	// visible objects by z: the scene keeps layer ranks up to date, so that
+	// objects are just distributed in per-layer buckets (in query order)
 	static Profiler viewRectProfiler("view rect object selection", 5000);
 	viewRectProfiler.begin();
-	auto objects = _scene->objects(_rect);
+	if (_layerBuckets.size() < size_t(_scene->layerCount()))
+		_layerBuckets.resize(_scene->layerCount());
+	_scene->objects(_rect, [this](Object* obj)
+		{
+			assert(obj->layerRank() >= 0 && obj->layerRank() < int(_layerBuckets.size()));
+			_layerBuckets[obj->layerRank()].push_back(obj);
+			return true;
+		});
 	viewRectProfiler.end();
-	std::sort(objects.begin(), objects.end(),
-		[](auto* a, auto* b) { return a->layer() < b->layer(); });
 
 	// render objects
-	for (auto& obj : objects)
+	for (auto& bucket : _layerBuckets)
 	{
-		RenderableObject* robj = obj->to<RenderableObject*>();
-		if (robj)
-			robj->draw(renderer, _scene2view);
+		for (auto& obj : bucket)
+		{
+			RenderableObject* robj = obj->to<RenderableObject*>();
+			if (robj)
+				robj->draw(renderer, _scene2view);
+		}
+		bucket.clear();
 	}
 }
 
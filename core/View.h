@@ -8,10 +8,12 @@
 // ----------------------------------------------------------------
 
 #pragma once
+#include <vector>
 #include "geometryUtils.h"
 
 namespace agp
 {
+	class Object;
 	class Scene;
 	class View;
 }
@@ -19,7 +21,8 @@ namespace agp
 // View (or camera) class
 // - a rectangular camera (view) installed on the game scene
 // - renders scene objects through a viewport
-// - only scene objects within the view's rect are drawn (culling)
+// - only scene objects within the view's rect are drawn (culling), in layer order
+//   (bucketed by the scene layer ranks, no sorting)
 // - handles scene2view and view2scene transforms
 class agp::View
 {
@@ -35,6 +38,7 @@ class agp::View
 		float _aspectRatio;			// fixed width/height aspect ratio (0 = not fixed)
 		RectF _clipRect;			// in relative [0,1] coords; if not set, _viewport is used
 		RectF _clipRectAbs;			// in absolute window coords
+		std::vector<std::vector<Object*>> _layerBuckets;	// visible objects per layer rank, reused across frames
 
 	public:
 
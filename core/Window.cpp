@@ -15,7 +15,7 @@
 
 using namespace agp;
 
-Window::Window(const std::string& title, int width, int height)
+Window::Window(const std::string& title, int width, int height, bool video)
 {
 	_window = nullptr;
 	_renderer = nullptr;
@@ -24,7 +24,7 @@ Window::Window(const std::string& title, int width, int height)
 	_width = width;
 	_height = height;
 
-	if (SDL_Init(SDL_INIT_VIDEO))
+	if (video && SDL_Init(SDL_INIT_VIDEO))
 		throw SDL_GetError();
 }
 
@@ -40,8 +40,8 @@ class agp::Window
 
 	public:
 
-		Window(const std::string& title, int width, int height);
-		~Window();
+		Window(const std::string& title, int width, int height, bool video = true);	// video = false: no SDL video (offscreen)
+		virtual ~Window();
 
 		// init (to be called once after creation)
 		virtual void init();
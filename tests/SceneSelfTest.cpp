@@ -0,0 +1,243 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#include "SceneSelfTest.h"
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include "GameScene.h"
+#include "RenderableObject.h"
+#include "View.h"
+#include "ObjectPool.h"
+#include "Quadtree.h"
+
+using namespace agp;
+
+namespace
+{
+    // scene stepped one fixed step at a time (no player, fixed camera)
+    class TestScene : public GameScene
+    {
+        public:
+
+            TestScene() : GameScene(RectF(0, 0, 100, 100), Point(16, 16), 1 / 60.0f)
+            {
+                _cameraFollowsPlayer = false;
+            }
+
+            float dt() const { return _dt; }
+            unsigned int steps() const { return _step; }
+            void step() { update(_dt); }
+    };
+
+    // short-lived pooled object releasing its sprite when destroyed (like projectiles)
+    class PooledEffect : public RenderableObject, public Pooled<PooledEffect>
+    {
+        public:
+
+            PooledEffect(Scene* scene, const RectF& rect) : RenderableObject(scene, rect, Color(255, 0, 0)) {}
+            virtual ~PooledEffect() { setSprite(nullptr, true); }
+    };
+
+    // object moving right at constant speed (1 scene unit per second), coarse-ticked when far
+    class Mover : public RenderableObject
+    {
+        public:
+
+            Mover(Scene* scene, const RectF& rect) : RenderableObject(scene, rect, Color(0, 0, 255))
+            {
+                setActivationPolicy(COARSE_TICK);
+            }
+
+            virtual void update(float dt) override
+            {
+                RenderableObject::update(dt);
+                setRect(RectF(rect().pos.x + dt, rect().pos.y, rect().size.x, rect().size.y));
+            }
+    };
+
+    // spawns an object in the given layer at its first update (like a projectile thrower)
+    class Spawner : public RenderableObject
+    {
+        private:
+
+            int _spawnLayer;
+
+        public:
+
+            Object* spawned = nullptr;
+
+            Spawner(Scene* scene, const RectF& rect, int spawnLayer) : RenderableObject(scene, rect, Color(0, 255, 0)), _spawnLayer(spawnLayer) {}
+
+            virtual void update(float dt) override
+            {
+                RenderableObject::update(dt);
+                if (!spawned)
+                    spawned = new RenderableObject(_scene, RectF(rect().pos.x + 1, rect().pos.y, 1, 1), Color(255, 0, 0), _spawnLayer);
+            }
+    };
+}
+
+SceneSelfTest::SceneSelfTest()
+{
+    _checks = 0;
+    _failures = 0;
+}
+
+void SceneSelfTest::check(const std::string& name, bool ok, const std::string& what)
+{
+    _checks++;
+    if (!ok)
+        _failures++;
+    printf("SceneSelfTest[%s] -> %s%s%s\n", name.c_str(), ok ? "ok" : "FAILED", what.empty() ? "" : ": ", what.c_str());
+}
+
+void SceneSelfTest::killPooledObjectReleasingSprite()
+{
+    // releasing the sprite wakes up objects not updated each step: the dying
+    // objects must not go back to the update list once out of the scene
+    TestScene scene;
+    Object* survivor = new PooledEffect(&scene, RectF(0, 0, 1, 1));
+    std::vector<Object*> effects;
+    for (int i = 0; i < 8; i++)
+        effects.push_back(new PooledEffect(&scene, RectF(2.0f + i, 0, 1, 1)));
+    scene.step();
+
+    for (auto obj : effects)
+        scene.killObject(obj);
+    for (int i = 0; i < 4; i++)
+        scene.step();
+
+    int stale = 0;
+    for (auto obj : scene.updatedObjects())
+        if (obj != survivor)
+            stale++;
+    check("kill pooled object releasing sprite", scene.objects().size() == 1 && stale == 0,
+        strprintf("%d objects, %d stale objects in the update list", int(scene.objects().size()), stale));
+}
+
+void SceneSelfTest::pauseTimersOfObjectsNotRunning()
+{
+    // timers of freezed or sleeping objects keep the time they have left
+    // (10 steps, 4 elapsed before the pause)
+    TestScene scene;
+    scene.view()->setRect(RectF(0, 0, 16, 16));
+    scene.setActivation(true, PointF(4, 4), PointF(4, 4));
+    RenderableObject* freezed = new RenderableObject(&scene, RectF(1, 1, 1, 1), Color(255, 0, 0));
+    RenderableObject* sleeping = new RenderableObject(&scene, RectF(80, 80, 1, 1), Color(255, 0, 0));
+    sleeping->setActivationPolicy(Object::FREEZE);
+
+    int firedAt[2] = { -1, -1 };
+    freezed->schedule("timer", 10 * scene.dt(), [&]() { firedAt[0] = scene.steps(); });
+    sleeping->schedule("timer", 10 * scene.dt(), [&]() { firedAt[1] = scene.steps(); });
+    for (int i = 0; i < 4; i++)
+        scene.step();
+
+    freezed->setFreezed(true);
+    for (int i = 0; i < 100; i++)
+        scene.step();
+
+    // the sleeping object may have counted down a step or two before sleeping
+    int resumedAt = scene.steps();
+    freezed->setFreezed(false);
+    scene.view()->setRect(RectF(72, 72, 16, 16));
+    for (int i = 0; i < 20; i++)
+        scene.step();
+
+    check("pause timers of objects not running", firedAt[0] == resumedAt + 6 && firedAt[1] >= resumedAt + 6 && firedAt[1] <= resumedAt + 10,
+        strprintf("resumed at step %d, fired at steps %d (freezed) and %d (sleeping)", resumedAt, firedAt[0], firedAt[1]));
+}
+
+void SceneSelfTest::renderObjectsSpawnedMidStep()
+{
+    // objects spawned during a step are in the spatial index (thus visible) before
+    // they join the scene objects: they must already have a layer rank, also when
+    // their layer is new (below and above the layers in use)
+    TestScene scene;
+    scene.setUseQuadtree(true);
+    scene.view()->setRect(RectF(0, 0, 16, 16));
+    new RenderableObject(&scene, RectF(8, 8, 1, 1), Color(0, 0, 255), 1);
+    std::vector<Spawner*> spawners = { new Spawner(&scene, RectF(1, 1, 1, 1), -1), new Spawner(&scene, RectF(1, 3, 1, 1), 2) };
+    scene.step();
+
+    bool ranked = true;
+    for (auto spawner : spawners)
+    {
+        Object* obj = spawner->spawned;
+        ranked = ranked && obj && obj->layerRank() >= 0 && obj->layerRank() < scene.layerCount();
+    }
+    if (ranked)
+    {
+        // layers in use: -1, 0, 1, 2
+        ranked = scene.layerCount() == 4 &&
+            spawners[0]->spawned->layerRank() == 0 && spawners[0]->layerRank() == 1 && spawners[1]->spawned->layerRank() == 3;
+        scene.view()->render();
+    }
+
+    check("render objects spawned mid-step", ranked, strprintf("%d layers, %d objects spawning",
+        scene.layerCount(), int(scene.objects(RectF(0, 0, 16, 16)).size() - scene.objects().size())));
+}
+
+void SceneSelfTest::catchUpCoarseObjectsWhenWoken()
+{
+    // objects updated at 1/8 rate that wake up in the middle of a period must
+    // not lose the steps skipped since their last update
+    TestScene scene;
+    scene.setUseQuadtree(true);
+    scene.view()->setRect(RectF(0, 0, 16, 16));
+    scene.setActivation(true, PointF(4, 4), PointF(4, 4));
+    Mover* mover = new Mover(&scene, RectF(90, 1, 1, 1));
+    while (scene.steps() < 60)
+        scene.step();
+    bool coarse = mover->updateMode() == Object::UPDATE_COARSE;
+
+    // wakes up at the next step, then updated each step
+    scene.view()->setRect(RectF(84, 0, 16, 16));
+    for (int i = 0; i < 4; i++)
+        scene.step();
+
+    float expected = 90 + scene.steps() * scene.dt();
+    check("catch up coarse objects when woken", coarse && mover->updateMode() == Object::UPDATE_FULL && std::abs(mover->rect().pos.x - expected) < 1e-3f,
+        strprintf("x = %.4f after %d steps (expected %.4f)", mover->rect().pos.x, scene.steps(), expected));
+}
+
+void SceneSelfTest::removeAllFromQuadtree()
+{
+    // objects straddling the world center stay in the root (too many to merge the
+    // children into it): removed last, the root must collapse too
+    TestScene scene;
+    std::vector<Object*> objects;
+    for (int i = 0; i < 400; i++)
+        objects.push_back(new Object(&scene, RectF(float((i * 37) % 97), float((i * 61) % 97), 1, 1)));
+    for (int i = 0; i < 40; i++)
+        objects.push_back(new Object(&scene, RectF(40.0f + i % 5, 40.0f + i / 5, 12, 12)));
+    scene.step();
+
+    Quadtree quadtree(scene.rect());
+    for (auto obj : objects)
+        quadtree.add(obj);
+    std::size_t nodes = quadtree.nodesCount();
+    for (auto obj : objects)
+        quadtree.remove(obj);
+
+    check("remove all from quadtree", nodes > 1 && quadtree.nodesCount() == 1 && quadtree.queryObjects(scene.rect()).empty(),
+        strprintf("%d nodes with %d objects, %d nodes once empty", int(nodes), int(objects.size()), int(quadtree.nodesCount())));
+}
+
+int SceneSelfTest::runAll()
+{
+    killPooledObjectReleasingSprite();
+    pauseTimersOfObjectsNotRunning();
+    renderObjectsSpawnedMidStep();
+    catchUpCoarseObjectsWhenWoken();
+    removeAllFromQuadtree();
+
+    printf("(%d checks, %d failed)\n", _checks, _failures);
+    return _failures;
+}
@@ -0,0 +1,46 @@
+// ----------------------------------------------------------------
+// From "Algorithms and Game Programming" in C++ by Alessandro Bria
+// Copyright (C) 2024 Alessandro Bria (a.bria@unicas.it). 
+// All rights reserved.
+// 
+// Released under the BSD License
+// See LICENSE in root directory for full details.
+// ----------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+
+namespace agp
+{
+    class SceneSelfTest;
+}
+
+// Scene self test class
+// - regression checks of the scene object bookkeeping (object removal, update
+//   lists, timers), each one on a fresh GameScene stepped one fixed step at a time
+// - needs a Game instance (GameScene creates a view): offscreen rendering is enough
+// - each check prints its outcome, runAll returns the number of failed checks
+class agp::SceneSelfTest
+{
+    private:
+
+        int _checks;
+        int _failures;
+
+        void check(const std::string& name, bool ok, const std::string& what = "");
+
+        // checks
+        void killPooledObjectReleasingSprite();
+        void pauseTimersOfObjectsNotRunning();
+        void renderObjectsSpawnedMidStep();
+        void catchUpCoarseObjectsWhenWoken();
+        void removeAllFromQuadtree();
+
+    public:
+
+        SceneSelfTest();
+
+        // runs all checks and prints a report
+        int runAll();
+};
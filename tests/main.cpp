@@ -0,0 +1,28 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "Game.h"
+#include "core_version.h"
+#include "SceneSelfTest.h"
+
+// scene regression checks on an offscreen game (no SDL video)
+int main(int argc, char *argv[])
+{
+	printf("Core v%s\n\n", agp::core::VERSION().c_str());
+
+	try
+	{
+		agp::Game::setInstance(new agp::Game("tests", agp::Point(600, 600), 1, agp::Game::Rendering::OFFSCREEN));
+		return agp::SceneSelfTest().runAll() ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+	catch (const char* errMsg)
+	{
+		printf("ERROR: %s\n", errMsg);
+	}
+	catch (std::string errMsg)
+	{
+		printf("ERROR: %s\n", errMsg.c_str());
+	}
+
+	return EXIT_FAILURE;
+}
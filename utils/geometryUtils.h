@@ -351,6 +351,14 @@ namespace agp
 				pos.y <= r.pos.y && (r.pos.y + r.size.y) <= (pos.y + size.y);
 		}
 
+		// distance from a point (0 if the point is inside)
+		inline T distance(const Vec2D<T>& p) const
+		{
+			T dx = std::max(std::max(pos.x - p.x, p.x - (pos.x + size.x)), T(0));
+			T dy = std::max(std::max(pos.y - p.y, p.y - (pos.y + size.y)), T(0));
+			return std::sqrt(dx * dx + dy * dy);
+		}
+
 		inline Vec2D<T> center() const
 		{
 			return Vec2D<T>(pos.x + size.x / 2, pos.y + size.y / 2);